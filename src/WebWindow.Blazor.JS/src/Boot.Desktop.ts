@@ -6,9 +6,11 @@ import { internalFunctions as navigationManagerFunctions } from '@browserjs/Serv
 import { renderBatch } from '@browserjs/Rendering/Renderer';
 import { decode } from 'base64-arraybuffer';
 import * as ipc from './IPC';
+import * as interactionLatency from './InteractionLatency';
+import { PersistentStringRenderBatch, PersistentStringTable } from './PersistentStringRenderBatch';
 
 function boot() {
-  setEventDispatcher((eventDescriptor, eventArgs) => DotNet.invokeMethodAsync('WebWindow.Blazor', 'DispatchEvent', eventDescriptor, JSON.stringify(eventArgs)));
+  setEventDispatcher((eventDescriptor, eventArgs) => DotNet.invokeMethodAsync('WebWindow.Blazor', 'DispatchEvent', eventDescriptor, JSON.stringify(eventArgs), interactionLatency.beginInteraction()));
   navigationManagerFunctions.listenForNavigationEvents((uri: string, intercepted: boolean) => {
     return DotNet.invokeMethodAsync('WebWindow.Blazor', 'NotifyLocationChanged', uri, intercepted);
   });
@@ -33,9 +35,56 @@ function boot() {
     DotNet.jsCallDispatcher.endInvokeDotNetFromJS(callId, success, resultOrError);
   });
 
-  ipc.on('JS.RenderBatch', (rendererId, batchBase64) => {
+  const persistentStrings = new PersistentStringTable();
+  ipc.on('JS.RenderBatch', (rendererId, batchBase64, usesPersistentStrings, interactionId: number, resetsPersistentStrings: boolean) => {
+    const receivedTime = performance.now();
+    if (resetsPersistentStrings) {
+      persistentStrings.clear();
+    }
+
     var batchData = new Uint8Array(decode(batchBase64));
-    renderBatch(rendererId, new OutOfProcessRenderBatch(batchData));
+    renderBatch(rendererId, usesPersistentStrings
+      ? new PersistentStringRenderBatch(batchData, persistentStrings)
+      : new OutOfProcessRenderBatch(batchData));
+
+    if (interactionId) {
+      interactionLatency.completeInteraction(interactionId, receivedTime);
+    }
+  });
+
+  ipc.on('JS.RenderFrame', (rendererId, usesPersistentStrings, batchesBase64: string[], interactionIds: number[], persistentStringResets: number[]) => {
+    const receivedTime = performance.now();
+    scheduleFrame(() => {
+      // .NET holds back every later frame until this one is acknowledged, so always acknowledge it
+      let error: string | null = null;
+      try {
+        // Decoding a batch applies its string table assignments. Do that for every batch before
+        // rendering any, so one failing to render can't leave our table behind the .NET one.
+        const batches = batchesBase64.map((batchBase64, index) => {
+          if (persistentStringResets.indexOf(index) >= 0) {
+            persistentStrings.clear();
+          }
+
+          const batchData = new Uint8Array(decode(batchBase64));
+          return usesPersistentStrings
+            ? new PersistentStringRenderBatch(batchData, persistentStrings)
+            : new OutOfProcessRenderBatch(batchData);
+        });
+
+        batches.forEach(batch => renderBatch(rendererId, batch));
+
+        interactionIds.forEach(interactionId => interactionLatency.completeInteraction(interactionId, receivedTime));
+      } catch (ex) {
+        error = (ex && ex.stack) || String(ex);
+      } finally {
+        const framesDropped = Math.floor((performance.now() - receivedTime) / frameIntervalMs);
+        ipc.send('OnRenderFrameCompleted', [framesDropped, error]);
+      }
+    });
+  });
+
+  ipc.on('JS.EnableInteractionLatency', () => {
+    interactionLatency.enable();
   });
 
   ipc.on('JS.Error', (message) => {
@@ -48,4 +97,44 @@ function boot() {
     navigationManagerFunctions.getBaseURI()]);
 }
 
+const frameFallbackTimeoutMs = 100;
+
+// Starts at 60Hz, and is refined from requestAnimationFrame timestamps as frames are rendered
+let frameIntervalMs = 1000 / 60;
+let hasMeasuredFrameInterval = false;
+
+// requestAnimationFrame doesn't fire while the page is hidden, but .NET keeps queueing batches
+// until we acknowledge the current frame, so fall back on a timer rather than stall indefinitely
+function scheduleFrame(callback: () => void) {
+  let done = false;
+  const runOnce = () => {
+    if (!done) {
+      done = true;
+      callback();
+    }
+  };
+
+  requestAnimationFrame(timestamp => {
+    runOnce();
+    requestAnimationFrame(nextTimestamp => recordFrameInterval(nextTimestamp - timestamp));
+  });
+  setTimeout(runOnce, frameFallbackTimeoutMs);
+}
+
+// Two consecutive callbacks are normally one display frame apart, but can be more if the
+// browser skipped frames, so intervals much longer than the current estimate are ignored
+function recordFrameInterval(intervalMs: number) {
+  if (intervalMs <= 0) {
+    return;
+  }
+
+  if (!hasMeasuredFrameInterval || intervalMs < frameIntervalMs * 0.75) {
+    // Either the first measurement, or the first one was itself a skipped frame
+    frameIntervalMs = intervalMs;
+    hasMeasuredFrameInterval = true;
+  } else if (intervalMs < frameIntervalMs * 1.5) {
+    frameIntervalMs = frameIntervalMs * 0.9 + intervalMs * 0.1;
+  }
+}
+
 boot();
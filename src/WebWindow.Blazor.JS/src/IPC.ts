@@ -29,18 +29,53 @@ export function once(eventName: string, callback: Callback): void {
     on(eventName, callbackOnce);
 }
 
+// A batch carries several messages in one frame. Its args are an array of [eventName, args] pairs.
+const batchEventName = '__batch';
+
+let pendingSends: [string, any][] | null = null;
+
+// Everything sent during the same JavaScript turn (e.g., the interop calls made while handling
+// one DOM event) goes out as a single message when the turn ends
 export function send(eventName: string, args: any): void {
+    if (!pendingSends) {
+        pendingSends = [];
+        Promise.resolve().then(flushPendingSends);
+    }
+
+    pendingSends.push([eventName, args]);
+}
+
+function flushPendingSends() {
+    const batch = pendingSends!;
+    pendingSends = null;
+
+    if (batch.length === 1) {
+        sendMessage(batch[0][0], batch[0][1]);
+    } else {
+        sendMessage(batchEventName, batch);
+    }
+}
+
+function sendMessage(eventName: string, args: any) {
     (window as any).external.sendMessage(`ipc:${eventName} ${JSON.stringify(args)}`);
 }
 
+function dispatch(eventName: string, args: any[]) {
+    const group = registrations[eventName];
+    if (group) {
+        group.forEach(callback => callback.apply(null, args));
+    }
+}
+
 (window as any).external.receiveMessage((message: string) => {
     const colonPos = message.indexOf(':');
     const eventName = message.substring(0, colonPos);
     const argsJson = message.substr(colonPos + 1);
 
-    const group = registrations[eventName];
-    if (group) {
-        const args: any[] = JSON.parse(argsJson);
-        group.forEach(callback => callback.apply(null, args));
+    if (eventName === batchEventName) {
+        const entries: [string, any[]][] = JSON.parse(argsJson);
+        entries.forEach(entry => dispatch(entry[0], entry[1]));
+    } else if (registrations[eventName]) {
+        dispatch(eventName, JSON.parse(argsJson));
     }
 });
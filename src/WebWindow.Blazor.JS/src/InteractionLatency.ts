@@ -0,0 +1,62 @@
+import * as ipc from './IPC';
+
+interface PendingInteraction {
+  id: number;
+  eventTime: number;
+  sendTime: number;
+}
+
+// Events that don't cause a render never complete, so only keep the most recent few
+const maxPendingInteractions = 100;
+
+let isEnabled = false;
+let nextInteractionId = 1;
+const pendingInteractions: PendingInteraction[] = [];
+
+export function enable() {
+  isEnabled = true;
+}
+
+// Call while a DOM event is being dispatched to .NET. Returns the ID that .NET will tag the
+// resulting render batch with, or 0 if tracking is disabled.
+export function beginInteraction(): number {
+  if (!isEnabled) {
+    return 0;
+  }
+
+  // Event timestamps use the same clock as performance.now(), but fall back on the dispatch
+  // time if there's no current event or its timestamp looks like it's from another clock
+  const now = performance.now();
+  const event = (window as any).event as Event | undefined;
+  const eventTime = event && event.timeStamp > 0 && event.timeStamp <= now ? event.timeStamp : now;
+
+  const id = nextInteractionId++;
+  pendingInteractions.push({ id, eventTime, sendTime: now });
+  if (pendingInteractions.length > maxPendingInteractions) {
+    pendingInteractions.shift();
+  }
+
+  return id;
+}
+
+// Call once the render batch tagged with the interaction's ID has been applied to the DOM
+export function completeInteraction(id: number, batchReceivedTime: number) {
+  let index = 0;
+  while (index < pendingInteractions.length && pendingInteractions[index].id < id) {
+    index++;
+  }
+
+  if (index === pendingInteractions.length || pendingInteractions[index].id !== id) {
+    return;
+  }
+
+  // Batches are applied in order, so any earlier interaction that's still pending didn't render
+  const interaction = pendingInteractions.splice(0, index + 1)[index];
+  const now = performance.now();
+  ipc.send('OnInteractionCompleted', [
+    id,
+    interaction.sendTime - interaction.eventTime,
+    now - batchReceivedTime,
+    now - interaction.eventTime
+  ]);
+}
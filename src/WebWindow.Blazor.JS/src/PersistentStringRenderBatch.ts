@@ -0,0 +1,188 @@
+import { OutOfProcessRenderBatch } from '@browserjs/Rendering/RenderBatch/OutOfProcessRenderBatch';
+import { RenderTreeFrameReader, RenderTreeEditReader, RenderTreeFrame, RenderTreeEdit } from '@browserjs/Rendering/RenderBatch/RenderBatch';
+import { decodeUtf8 } from '@browserjs/Rendering/RenderBatch/Utf8Decoder';
+
+const stringTableEntryLength = 4;
+const trailerLength = 20; // The five int32 offsets written at the end of every batch
+const slotAssignmentEntryLength = 8; // Each is an int32 slot followed by an int32 string table index
+
+// Mirrors RenderBatchStringTable on the .NET side. The .NET side decides which slot each
+// string lives in, and each batch tells us about the assignments it made, so all we have
+// to do here is store them.
+export class PersistentStringTable {
+  private strings: string[] = [];
+
+  assign(slot: number, value: string) {
+    this.strings[slot] = value;
+  }
+
+  get(slot: number): string {
+    return this.strings[slot];
+  }
+
+  // .NET empties its table when ours may have drifted from it, and tells us to do the same
+  clear() {
+    this.strings = [];
+  }
+
+  snapshot(): PersistentStringTable {
+    const result = new PersistentStringTable();
+    result.strings = this.strings.slice();
+    return result;
+  }
+}
+
+// Render batches written with a persistent string table use the same format as regular
+// out-of-process batches, except that:
+//  * String indices of -2 and below refer to persistent string table slot (-2 - index)
+//  * The slot assignments made by this batch are written immediately before the trailer,
+//    as (slot, index) pairs followed by the number of pairs
+export class PersistentStringRenderBatch extends OutOfProcessRenderBatch {
+  constructor(data: Uint8Array, stringTable: PersistentStringTable) {
+    super(data);
+
+    // Apply all the assignments up front, since frames anywhere in the batch may refer to them
+    const stringTableStartIndex = readInt32LE(data, data.length - 4); // Final int gives start position of the string table
+    const countPos = data.length - trailerLength - 4;
+    const count = readInt32LE(data, countPos);
+    const firstEntryPos = countPos - count * slotAssignmentEntryLength;
+    for (let i = 0; i < count; i++) {
+      const entryPos = firstEntryPos + i * slotAssignmentEntryLength;
+      const slot = readInt32LE(data, entryPos);
+      const stringIndex = readInt32LE(data, entryPos + 4);
+      stringTable.assign(slot, readBatchString(data, stringTableStartIndex, stringIndex));
+    }
+
+    // A frame's batches all apply their assignments before any of them is rendered, and a
+    // later batch may reuse a slot this one refers to, so resolve against the table as it is now
+    const stringResolver = new PersistentStringResolver(data, stringTableStartIndex, stringTable.snapshot());
+    this.frameReader = new PersistentStringFrameReader(data, this.frameReader, stringResolver);
+    this.editReader = new PersistentStringEditReader(data, this.editReader, stringResolver);
+  }
+}
+
+class PersistentStringResolver {
+  constructor(private data: Uint8Array, private stringTableStartIndex: number, private stringTable: PersistentStringTable) {
+  }
+
+  readString(index: number): string | null {
+    if (index === -1) { // Special value encodes 'null'
+      return null;
+    } else if (index < -1) {
+      return this.stringTable.get(-2 - index);
+    } else {
+      return readBatchString(this.data, this.stringTableStartIndex, index);
+    }
+  }
+}
+
+function readBatchString(data: Uint8Array, stringTableStartIndex: number, index: number): string {
+  const stringTableEntryPos = readInt32LE(data, stringTableStartIndex + index * stringTableEntryLength);
+  const numUtf8Bytes = readLEB128(data, stringTableEntryPos);
+  const charsStart = stringTableEntryPos + numLEB128Bytes(numUtf8Bytes);
+  const utf8Data = new Uint8Array(
+    data.buffer,
+    data.byteOffset + charsStart,
+    numUtf8Bytes
+  );
+  return decodeUtf8(utf8Data);
+}
+
+// The string-valued properties are read at the same offsets as OutOfProcessRenderBatch uses.
+// Everything else is delegated unchanged.
+class PersistentStringFrameReader implements RenderTreeFrameReader {
+  constructor(private data: Uint8Array, private inner: RenderTreeFrameReader, private strings: PersistentStringResolver) {
+  }
+
+  frameType(frame: RenderTreeFrame) {
+    return this.inner.frameType(frame);
+  }
+
+  subtreeLength(frame: RenderTreeFrame) {
+    return this.inner.subtreeLength(frame);
+  }
+
+  elementReferenceCaptureId(frame: RenderTreeFrame) {
+    return this.strings.readString(readInt32LE(this.data, frame as any + 4)); // 2nd int
+  }
+
+  componentId(frame: RenderTreeFrame) {
+    return this.inner.componentId(frame);
+  }
+
+  elementName(frame: RenderTreeFrame) {
+    return this.strings.readString(readInt32LE(this.data, frame as any + 8)); // 3rd int
+  }
+
+  textContent(frame: RenderTreeFrame) {
+    return this.strings.readString(readInt32LE(this.data, frame as any + 4)); // 2nd int
+  }
+
+  markupContent(frame: RenderTreeFrame) {
+    return this.strings.readString(readInt32LE(this.data, frame as any + 4))!; // 2nd int
+  }
+
+  attributeName(frame: RenderTreeFrame) {
+    return this.strings.readString(readInt32LE(this.data, frame as any + 4)); // 2nd int
+  }
+
+  attributeValue(frame: RenderTreeFrame) {
+    return this.strings.readString(readInt32LE(this.data, frame as any + 8)); // 3rd int
+  }
+
+  attributeEventHandlerId(frame: RenderTreeFrame) {
+    return this.inner.attributeEventHandlerId(frame);
+  }
+}
+
+class PersistentStringEditReader implements RenderTreeEditReader {
+  constructor(private data: Uint8Array, private inner: RenderTreeEditReader, private strings: PersistentStringResolver) {
+  }
+
+  editType(edit: RenderTreeEdit) {
+    return this.inner.editType(edit);
+  }
+
+  siblingIndex(edit: RenderTreeEdit) {
+    return this.inner.siblingIndex(edit);
+  }
+
+  newTreeIndex(edit: RenderTreeEdit) {
+    return this.inner.newTreeIndex(edit);
+  }
+
+  moveToSiblingIndex(edit: RenderTreeEdit) {
+    return this.inner.moveToSiblingIndex(edit);
+  }
+
+  removedAttributeName(edit: RenderTreeEdit) {
+    return this.strings.readString(readInt32LE(this.data, edit as any + 12)); // 4th int
+  }
+}
+
+function readInt32LE(buffer: Uint8Array, position: number): any {
+  return (buffer[position])
+    | (buffer[position + 1] << 8)
+    | (buffer[position + 2] << 16)
+    | (buffer[position + 3] << 24);
+}
+
+function readLEB128(buffer: Uint8Array, position: number) {
+  let result = 0;
+  let shift = 0;
+  for (let index = 0; index < 4; index++) {
+    const byte = buffer[position + index];
+    result |= (byte & 127) << shift;
+    if (byte < 128) {
+      break;
+    }
+    shift += 7;
+  }
+  return result;
+}
+
+function numLEB128Bytes(value: number) {
+  return value < 128 ? 1
+    : value < 16384 ? 2
+      : value < 2097152 ? 3 : 4;
+}
@@ -0,0 +1,145 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Threading.Tasks;
+
+namespace WebWindows.Blazor
+{
+    /// <summary>
+    /// Reads the assets listed in a prefetch manifest on background threads while the web view
+    /// is still starting, so each one can be served from memory as soon as it's requested.
+    ///
+    /// The manifest is a text file with one URL per line. It can be generated at build time, but
+    /// normally it's recorded: every URL requested before the app finishes starting is noted,
+    /// and the list is written back to the manifest if it changed.
+    /// </summary>
+    internal class AssetPrefetcher
+    {
+        public delegate Stream OpenAssetDelegate(string url);
+
+        private readonly string _manifestPath;
+        private readonly OpenAssetDelegate _openAsset;
+        private readonly ConcurrentDictionary<string, Task<byte[]>> _staged = new ConcurrentDictionary<string, Task<byte[]>>();
+        private readonly string[] _manifestUrls;
+        private readonly object _requestedUrlsLock = new object();
+        private List<string> _requestedUrls = new List<string>(); // Null once startup has finished
+
+        public AssetPrefetcher(string manifestPath, OpenAssetDelegate openAsset)
+        {
+            _manifestPath = manifestPath;
+            _openAsset = openAsset;
+            _manifestUrls = ReadManifest(manifestPath);
+        }
+
+        /// <summary>
+        /// Starts reading every asset in the manifest. Returns immediately.
+        /// </summary>
+        public void Start()
+        {
+            foreach (var url in _manifestUrls)
+            {
+                _staged.TryAdd(url, Task.Run(() => ReadAsset(url)));
+            }
+        }
+
+        /// <summary>
+        /// Called for every request the web view makes, whether or not it was prefetched.
+        /// </summary>
+        /// <returns>The staged asset, or null if the request should be handled normally.</returns>
+        public Stream TryTake(string url)
+        {
+            lock (_requestedUrlsLock)
+            {
+                if (_requestedUrls != null && !_requestedUrls.Contains(url))
+                {
+                    _requestedUrls.Add(url);
+                }
+            }
+
+            // This runs on the UI thread on some platforms, so don't wait for a read that's still
+            // in progress. Reading again through the normal handler is no worse than not prefetching.
+            if (!_staged.TryRemove(url, out var staged) || !staged.IsCompletedSuccessfully)
+            {
+                return null;
+            }
+
+            var bytes = staged.Result;
+            return bytes == null
+                ? null
+                : new MemoryStream(bytes, 0, bytes.Length, writable: false, publiclyVisible: true);
+        }
+
+        /// <summary>
+        /// Called once the app has started. Drops anything that was prefetched but never
+        /// requested, and updates the manifest if this run requested a different set of URLs.
+        /// </summary>
+        public void CompleteStartup()
+        {
+            List<string> requestedUrls;
+            lock (_requestedUrlsLock)
+            {
+                requestedUrls = _requestedUrls;
+                _requestedUrls = null;
+            }
+
+            _staged.Clear();
+
+            if (requestedUrls != null && !requestedUrls.SequenceEqual(_manifestUrls))
+            {
+                try
+                {
+                    File.WriteAllLines(_manifestPath, requestedUrls);
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    // The manifest is only an optimization, so carry on without it
+                    Console.Error.WriteLine($"Could not write asset prefetch manifest '{_manifestPath}': {ex.Message}");
+                }
+            }
+        }
+
+        private byte[] ReadAsset(string url)
+        {
+            try
+            {
+                using (var stream = _openAsset(url))
+                {
+                    if (stream == null)
+                    {
+                        return null;
+                    }
+
+                    using (var ms = new MemoryStream())
+                    {
+                        stream.CopyTo(ms);
+                        return ms.ToArray();
+                    }
+                }
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                // Returning null sends the request through the normal handler, which reports the error
+                return null;
+            }
+        }
+
+        private static string[] ReadManifest(string manifestPath)
+        {
+            try
+            {
+                return File.ReadAllLines(manifestPath)
+                    .Select(line => line.Trim())
+                    .Where(line => line.Length > 0)
+                    .Distinct()
+                    .ToArray();
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                // Most likely this is the first run, and the manifest will be recorded this time
+                return Array.Empty<string>();
+            }
+        }
+    }
+}
@@ -22,37 +22,73 @@ namespace WebWindows.Blazor
         internal static DesktopJSRuntime DesktopJSRuntime { get; private set; }
         internal static DesktopRenderer DesktopRenderer { get; private set; }
         internal static WebWindow WebWindow { get; private set; }
+        internal static DesktopSynchronizationContext DesktopSynchronizationContext { get; private set; }
+        internal static InteractionLatencyTracker InteractionLatencyTracker { get; private set; }
+
+        /// <summary>
+        /// Gets the frame pacing counters, or null if <see cref="ComponentsDesktopOptions.UseFramePacing"/>
+        /// is not enabled or the app hasn't started yet.
+        /// </summary>
+        public static RenderFrameStatistics? RenderFrameStatistics => DesktopRenderer?.FrameStatistics;
+
+        /// <summary>
+        /// Gets the queue depth and wait time counters for each priority lane of the app's
+        /// synchronization context, or null if the app hasn't started yet.
+        /// </summary>
+        public static DesktopSynchronizationContextStatistics? SynchronizationContextStatistics
+            => DesktopSynchronizationContext?.Statistics;
 
         public static void Run<TStartup>(string windowTitle, string hostHtmlPath)
+            => Run<TStartup>(windowTitle, hostHtmlPath, _ => { });
+
+        public static void Run<TStartup>(string windowTitle, string hostHtmlPath, Action<ComponentsDesktopOptions> configure)
         {
+            if (configure is null)
+            {
+                throw new ArgumentNullException(nameof(configure));
+            }
+
+            var desktopOptions = new ComponentsDesktopOptions();
+            configure.Invoke(desktopOptions);
+
             DesktopSynchronizationContext.UnhandledException += (sender, exception) =>
             {
                 UnhandledException(exception);
             };
 
+            var contentRootAbsolute = Path.GetDirectoryName(Path.GetFullPath(hostHtmlPath));
+
+            // Start reading the startup assets now, so it overlaps with the web view starting up
+            AssetPrefetcher assetPrefetcher = null;
+            if (desktopOptions.AssetPrefetchManifestPath != null)
+            {
+                assetPrefetcher = new AssetPrefetcher(desktopOptions.AssetPrefetchManifestPath, url => url.StartsWith("framework:", StringComparison.Ordinal)
+                    ? SupplyFrameworkFile(url)
+                    : SupplyAppFile(url, contentRootAbsolute, hostHtmlPath));
+                assetPrefetcher.Start();
+            }
+
             WebWindow = new WebWindow(windowTitle, options =>
             {
-                var contentRootAbsolute = Path.GetDirectoryName(Path.GetFullPath(hostHtmlPath));
+                // IPC preserves message order either way, but this keeps .NET code off the UI thread
+                options.DeliverWebMessagesOnBackgroundThread = true;
+                options.Headless = desktopOptions.Headless;
+                options.HeadlessViewportWidth = desktopOptions.HeadlessViewportWidth;
+                options.HeadlessViewportHeight = desktopOptions.HeadlessViewportHeight;
+                options.TrimMemoryOnPressure = desktopOptions.TrimMemoryOnPressure;
+                options.WebProcessMemoryLimitMegabytes = desktopOptions.WebProcessMemoryLimitMegabytes;
 
                 options.SchemeHandlers.Add(BlazorAppScheme, (string url, out string contentType) =>
                 {
-                    // TODO: Only intercept for the hostname 'app' and passthrough for others
-                    // TODO: Prevent directory traversal?
-                    var appFile = Path.Combine(contentRootAbsolute, new Uri(url).AbsolutePath.Substring(1));
-                    if (appFile == contentRootAbsolute)
-                    {
-                        appFile = hostHtmlPath;
-                    }
-
-                    contentType = GetContentType(appFile);
-                    return File.Exists(appFile) ? File.OpenRead(appFile) : null;
+                    contentType = GetContentType(GetAppFilePath(url, contentRootAbsolute, hostHtmlPath));
+                    return assetPrefetcher?.TryTake(url) ?? SupplyAppFile(url, contentRootAbsolute, hostHtmlPath);
                 });
 
                 // framework:// is resolved as embedded resources
                 options.SchemeHandlers.Add("framework", (string url, out string contentType) =>
                 {
                     contentType = GetContentType(url);
-                    return SupplyFrameworkFile(url);
+                    return assetPrefetcher?.TryTake(url) ?? SupplyFrameworkFile(url);
                 });
             });
 
@@ -61,8 +97,8 @@ namespace WebWindows.Blazor
             {
                 try
                 {
-                    var ipc = new IPC(WebWindow);
-                    await RunAsync<TStartup>(ipc, appLifetimeCts.Token);
+                    var ipc = new IPC(WebWindow, desktopOptions.BatchIpcMessages);
+                    await RunAsync<TStartup>(ipc, desktopOptions, assetPrefetcher, appLifetimeCts.Token);
                 }
                 catch (Exception ex)
                 {
@@ -114,7 +150,7 @@ namespace WebWindows.Blazor
             WebWindow.ShowMessage("Error", $"{ex.Message}\n{ex.StackTrace}");
         }
 
-        private static async Task RunAsync<TStartup>(IPC ipc, CancellationToken appLifetime)
+        private static async Task RunAsync<TStartup>(IPC ipc, ComponentsDesktopOptions desktopOptions, AssetPrefetcher assetPrefetcher, CancellationToken appLifetime)
         {
             var configurationBuilder = new ConfigurationBuilder()
                 .SetBasePath(Directory.GetCurrentDirectory())
@@ -122,6 +158,17 @@ namespace WebWindows.Blazor
 
             DesktopJSRuntime = new DesktopJSRuntime(ipc);
             await PerformHandshakeAsync(ipc);
+
+            // By now the page and all its scripts have loaded
+            assetPrefetcher?.CompleteStartup();
+
+            if (desktopOptions.TrackInteractionLatency)
+            {
+                LatencyStatistics.IsEnabled = true;
+                InteractionLatencyTracker = new InteractionLatencyTracker(ipc);
+                ipc.Send("JS.EnableInteractionLatency");
+            }
+
             AttachJsInterop(ipc, appLifetime);
 
             var serviceCollection = new ServiceCollection();
@@ -141,7 +188,7 @@ namespace WebWindows.Blazor
 
             var loggerFactory = services.GetRequiredService<ILoggerFactory>();
 
-            DesktopRenderer = new DesktopRenderer(services, ipc, loggerFactory);
+            DesktopRenderer = new DesktopRenderer(services, ipc, loggerFactory, desktopOptions);
             DesktopRenderer.UnhandledException += (sender, exception) =>
             {
                 Console.Error.WriteLine(exception);
@@ -153,6 +200,20 @@ namespace WebWindows.Blazor
             }
         }
 
+        private static string GetAppFilePath(string url, string contentRootAbsolute, string hostHtmlPath)
+        {
+            // TODO: Only intercept for the hostname 'app' and passthrough for others
+            // TODO: Prevent directory traversal?
+            var appFile = Path.Combine(contentRootAbsolute, new Uri(url).AbsolutePath.Substring(1));
+            return appFile == contentRootAbsolute ? hostHtmlPath : appFile;
+        }
+
+        private static Stream SupplyAppFile(string url, string contentRootAbsolute, string hostHtmlPath)
+        {
+            var appFile = GetAppFilePath(url, contentRootAbsolute, hostHtmlPath);
+            return File.Exists(appFile) ? File.OpenRead(appFile) : null;
+        }
+
         private static Stream SupplyFrameworkFile(string uri)
         {
             switch (uri)
@@ -183,32 +244,52 @@ namespace WebWindows.Blazor
         {
             var desktopSynchronizationContext = new DesktopSynchronizationContext(appLifetime);
             SynchronizationContext.SetSynchronizationContext(desktopSynchronizationContext);
+            DesktopSynchronizationContext = desktopSynchronizationContext;
+
+            // These handlers may run on the only thread that delivers messages from the browser, so
+            // they post rather than wait for the queue. Otherwise one slow handler would hold up
+            // everything behind it, including the JS results that .NET code may be waiting for.
+            // They all use the same lane, so messages are still handled in the order they arrived.
+            // Interop calls that arrive together are dispatched together, and the handlers below
+            // then run inline, since they're already on the right thread.
+            ipc.BatchDispatcher = dispatchBatch => desktopSynchronizationContext.Post(
+                state => ((Action)state)(), dispatchBatch, WorkPriority.Input);
 
             ipc.On("BeginInvokeDotNetFromJS", args =>
             {
-                desktopSynchronizationContext.Send(state =>
+                var receivedTimestamp = IPC.CurrentMessageReceivedTimestamp;
+                desktopSynchronizationContext.PostOrRunInline(state =>
                 {
                     var argsArray = (object[])state;
-                    DotNetDispatcher.BeginInvokeDotNet(
-                        DesktopJSRuntime,
-                        new DotNetInvocationInfo(
-                            assemblyName: ((JsonElement)argsArray[1]).GetString(),
-                            methodIdentifier: ((JsonElement)argsArray[2]).GetString(),
-                            dotNetObjectId: ((JsonElement)argsArray[3]).GetInt64(),
-                            callId: ((JsonElement)argsArray[0]).GetString()),
-                        ((JsonElement)argsArray[4]).GetString());
-                }, args);
+                    var latencyTracker = InteractionLatencyTracker;
+                    latencyTracker?.BeginDispatch(receivedTimestamp);
+                    try
+                    {
+                        DotNetDispatcher.BeginInvokeDotNet(
+                            DesktopJSRuntime,
+                            new DotNetInvocationInfo(
+                                assemblyName: ((JsonElement)argsArray[1]).GetString(),
+                                methodIdentifier: ((JsonElement)argsArray[2]).GetString(),
+                                dotNetObjectId: ((JsonElement)argsArray[3]).GetInt64(),
+                                callId: ((JsonElement)argsArray[0]).GetString()),
+                            ((JsonElement)argsArray[4]).GetString());
+                    }
+                    finally
+                    {
+                        latencyTracker?.EndDispatch();
+                    }
+                }, args, WorkPriority.Input);
             });
 
             ipc.On("EndInvokeJSFromDotNet", args =>
             {
-                desktopSynchronizationContext.Send(state =>
+                desktopSynchronizationContext.PostOrRunInline(state =>
                 {
                     var argsArray = (object[])state;
                     DotNetDispatcher.EndInvokeJS(
                         DesktopJSRuntime,
                         ((JsonElement)argsArray[2]).GetString());
-                }, args);
+                }, args, WorkPriority.Input);
             });
         }
 
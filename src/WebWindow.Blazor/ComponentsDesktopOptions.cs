@@ -0,0 +1,79 @@
+﻿namespace WebWindows.Blazor
+{
+    public class ComponentsDesktopOptions
+    {
+        /// <summary>
+        /// If true, strings such as element names, attribute names and short attribute values
+        /// are kept in a string table that lives for the whole session, so each one is only sent
+        /// to the browser once instead of once per render batch.
+        /// </summary>
+        public bool UsePersistentRenderBatchStrings { get; set; }
+
+        /// <summary>
+        /// The maximum number of entries in the persistent render batch string table. When it's
+        /// full, the least recently used entries are replaced.
+        /// </summary>
+        public int PersistentRenderBatchStringCapacity { get; set; } = RenderBatchStringTable.DefaultCapacity;
+
+        /// <summary>
+        /// Strings longer than this are never added to the persistent render batch string table.
+        /// </summary>
+        public int PersistentRenderBatchStringMaxLength { get; set; } = RenderBatchStringTable.DefaultMaxStringLength;
+
+        /// <summary>
+        /// If true, render batches produced while the browser is still applying an earlier
+        /// one are combined and sent together, and the browser applies them at most once per
+        /// display frame. Component OnAfterRender callbacks then run only after the DOM has
+        /// actually been updated.
+        /// </summary>
+        public bool UseFramePacing { get; set; }
+
+        /// <summary>
+        /// If true, messages sent to the browser while an earlier send is still in progress are
+        /// combined into a single message. Messages from the browser are always batched per
+        /// JavaScript turn, and each incoming batch is dispatched in one synchronization context turn.
+        /// </summary>
+        public bool BatchIpcMessages { get; set; }
+
+        /// <summary>
+        /// If true, the time from each DOM event to the resulting DOM update is measured and broken
+        /// down into stages, which can be read from <see cref="LatencyStatistics"/>.
+        /// </summary>
+        public bool TrackInteractionLatency { get; set; }
+
+        /// <summary>
+        /// If set, the URLs the web view requests while the app is starting are recorded in this file.
+        /// On later runs, those assets are read on background threads while the web view is still
+        /// starting, and served from memory when requested. The file can also be generated at build
+        /// time, with one URL per line.
+        /// </summary>
+        public string AssetPrefetchManifestPath { get; set; }
+
+        /// <summary>
+        /// If true, and the platform supports it, cached memory is released automatically whenever the
+        /// system comes under memory pressure. See <see cref="WebWindowOptions.TrimMemoryOnPressure"/>.
+        /// </summary>
+        public bool TrimMemoryOnPressure { get; set; }
+
+        /// <summary>
+        /// See <see cref="WebWindowOptions.WebProcessMemoryLimitMegabytes"/>.
+        /// </summary>
+        public int WebProcessMemoryLimitMegabytes { get; set; }
+
+        /// <summary>
+        /// If true, and the platform supports it, the window renders offscreen and never appears
+        /// on screen. See <see cref="WebWindowOptions.Headless"/>.
+        /// </summary>
+        public bool Headless { get; set; }
+
+        /// <summary>
+        /// The width in pixels of the viewport when <see cref="Headless"/> is true.
+        /// </summary>
+        public int HeadlessViewportWidth { get; set; } = 1280;
+
+        /// <summary>
+        /// The height in pixels of the viewport when <see cref="Headless"/> is true.
+        /// </summary>
+        public int HeadlessViewportHeight { get; set; } = 720;
+    }
+}
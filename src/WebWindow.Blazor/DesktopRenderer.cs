@@ -20,6 +20,8 @@ namespace WebWindows.Blazor
         private const int RendererId = 0; // Not relevant, since we have only one renderer in Desktop
         private readonly IPC _ipc;
         private readonly IJSRuntime _jsRuntime;
+        private readonly RenderBatchStringTable _persistentStrings;
+        private readonly RenderFramePacer _framePacer;
         private static readonly Type _writer;
         private static readonly MethodInfo _writeMethod;
 
@@ -31,13 +33,33 @@ namespace WebWindows.Blazor
             _writeMethod = _writer.GetMethod("Write", new[] { typeof(RenderBatch).MakeByRefType() });
         }
 
-        public DesktopRenderer(IServiceProvider serviceProvider, IPC ipc, ILoggerFactory loggerFactory)
+        public DesktopRenderer(IServiceProvider serviceProvider, IPC ipc, ILoggerFactory loggerFactory, ComponentsDesktopOptions options)
             : base(serviceProvider, loggerFactory)
         {
             _ipc = ipc ?? throw new ArgumentNullException(nameof(ipc));
             _jsRuntime = serviceProvider.GetRequiredService<IJSRuntime>();
+
+            if (options.UsePersistentRenderBatchStrings)
+            {
+                _persistentStrings = new RenderBatchStringTable(
+                    options.PersistentRenderBatchStringCapacity,
+                    options.PersistentRenderBatchStringMaxLength);
+
+                // Reloading the page starts the browser with an empty table
+                ipc.On("components:init", _ => _persistentStrings.RequestReset());
+            }
+
+            if (options.UseFramePacing)
+            {
+                _framePacer = new RenderFramePacer(ipc, RendererId, _persistentStrings);
+            }
         }
 
+        /// <summary>
+        /// Gets the frame pacing counters, or null if frame pacing is not enabled.
+        /// </summary>
+        public RenderFrameStatistics? FrameStatistics => _framePacer?.Statistics;
+
         /// <summary>
         /// Notifies when a rendering exception occured.
         /// </summary>
@@ -78,10 +100,17 @@ namespace WebWindows.Blazor
         /// <inheritdoc />
         protected override Task UpdateDisplayAsync(in RenderBatch batch)
         {
+            var latencyTracker = ComponentsDesktop.InteractionLatencyTracker;
+            var interactionId = latencyTracker?.BeginRender() ?? 0;
+            var resetsPersistentStrings = _persistentStrings?.TryApplyRequestedReset() ?? false;
+
             string base64;
             using (var memoryStream = new MemoryStream())
             {
-                object renderBatchWriter = Activator.CreateInstance(_writer, new object[] { memoryStream, false });
+                var writerArgs = _persistentStrings == null
+                    ? new object[] { memoryStream, false }
+                    : new object[] { memoryStream, false, _persistentStrings };
+                object renderBatchWriter = Activator.CreateInstance(_writer, writerArgs);
                 using (renderBatchWriter as IDisposable)
                 {
                     _writeMethod.Invoke(renderBatchWriter, new object[] { batch });
@@ -91,7 +120,16 @@ namespace WebWindows.Blazor
                 base64 = Convert.ToBase64String(batchBytes);
             }
 
-            _ipc.Send("JS.RenderBatch", RendererId, base64);
+            if (_framePacer != null)
+            {
+                // Completes when the browser has applied the batch, so OnAfterRender sees the updated DOM
+                var applied = _framePacer.EnqueueBatch(base64, interactionId, resetsPersistentStrings);
+                latencyTracker?.EndRender(interactionId);
+                return applied;
+            }
+
+            _ipc.Send("JS.RenderBatch", RendererId, base64, _persistentStrings != null, interactionId, resetsPersistentStrings);
+            latencyTracker?.EndRender(interactionId);
 
             // TODO: Consider finding a way to get back a completion message from the Desktop side
             // in case there was an error. We don't really need to wait for anything to happen, since
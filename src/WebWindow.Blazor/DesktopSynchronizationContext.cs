@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Collections.Concurrent;
+using System.Diagnostics;
 using System.Threading;
 using System.Threading.Tasks;
 
@@ -21,12 +22,21 @@ namespace WebWindows.Blazor
             return this;
         }
 
+        // The renderer and component code rely on plain Post and Send running in the order they
+        // were called, so they all share one lane. Only callers that ask for a priority can jump it.
         public override void Post(SendOrPostCallback d, object state)
+            => Post(d, state, WorkPriority.Render);
+
+        public override void Send(SendOrPostCallback d, object state)
+            => Send(d, state, WorkPriority.Render);
+
+        public void Post(SendOrPostCallback d, object state, WorkPriority priority)
         {
-            _work.Queue.Add(new WorkItem() { Callback = d, Context = this, State = state, });
+            var item = _work.RentWorkItem(d, this, state, waitForCompletion: false);
+            _work.Enqueue(item, priority);
         }
 
-        public override void Send(SendOrPostCallback d, object state)
+        public void Send(SendOrPostCallback d, object state, WorkPriority priority)
         {
             if (_work.CheckAccess())
             {
@@ -34,17 +44,39 @@ namespace WebWindows.Blazor
             }
             else
             {
-                var completed = new ManualResetEventSlim();
-                _work.Queue.Add(new WorkItem() { Callback = d, Context = this, State = state, Completed = completed, });
-                completed.Wait();
+                var item = _work.RentWorkItem(d, this, state, waitForCompletion: true);
+                _work.Enqueue(item, priority);
+                item.Completed.Wait();
+
+                // The queue thread is done with the item once it has signalled completion
+                _work.ReturnWorkItem(item);
+            }
+        }
+
+        /// <summary>
+        /// Runs <paramref name="d"/> straight away if called on the queue thread, and otherwise
+        /// posts it. Unlike <see cref="Send(SendOrPostCallback, object, WorkPriority)"/>, the caller
+        /// never waits for the queue.
+        /// </summary>
+        public void PostOrRunInline(SendOrPostCallback d, object state, WorkPriority priority)
+        {
+            if (_work.CheckAccess())
+            {
+                _work.ProcessWorkitemInline(d, state);
+            }
+            else
+            {
+                Post(d, state, priority);
             }
         }
 
         public void Stop()
         {
-            _work.Queue.CompleteAdding();
+            _work.CompleteAdding();
         }
 
+        public DesktopSynchronizationContextStatistics Statistics => _work.GetStatistics();
+
         public static void CheckAccess()
         {
             var synchronizationContext = Current as DesktopSynchronizationContext;
@@ -58,56 +90,222 @@ namespace WebWindows.Blazor
 
         private class WorkQueue
         {
+            // Bounds how long the queue thread goes between checks for cancellation
+            private const int MaxItemsPerWake = 64;
+            private const int MaxPooledWorkItems = 256;
+
+            // A lane with work waiting lets at most this many items from higher-priority lanes go
+            // ahead of it, so a steady stream of input can't stop the UI repainting
+            private const int MaxItemsAheadOfWaitingLane = 8;
+
             private readonly Thread _thread;
             private readonly CancellationToken _cancellationToken;
+            private readonly Lane[] _lanes;
+            private readonly ManualResetEventSlim _workAvailable = new ManualResetEventSlim();
+            private readonly ConcurrentBag<WorkItem> _pool = new ConcurrentBag<WorkItem>();
+            private readonly object _addingLock = new object();
+            private volatile bool _isAddingCompleted;
 
             public WorkQueue(CancellationToken cancellationToken)
             {
                 _cancellationToken = cancellationToken;
+                _lanes = new Lane[(int)WorkPriority.Background + 1];
+                for (var i = 0; i < _lanes.Length; i++)
+                {
+                    _lanes[i] = new Lane();
+                }
+
                 _thread = new Thread(ProcessQueue);
                 _thread.Start();
             }
 
-            public BlockingCollection<WorkItem> Queue { get; } = new BlockingCollection<WorkItem>();
-
             public bool CheckAccess()
             {
                 return Thread.CurrentThread == _thread;
             }
 
+            public WorkItem RentWorkItem(SendOrPostCallback callback, SynchronizationContext context, object state, bool waitForCompletion)
+            {
+                if (!_pool.TryTake(out var item))
+                {
+                    item = new WorkItem();
+                }
+
+                item.Callback = callback;
+                item.Context = context;
+                item.State = state;
+                if (waitForCompletion)
+                {
+                    if (item.Completed == null)
+                    {
+                        item.Completed = new ManualResetEventSlim();
+                    }
+                    else
+                    {
+                        item.Completed.Reset();
+                    }
+                }
+
+                item.IsSend = waitForCompletion;
+                return item;
+            }
+
+            public void ReturnWorkItem(WorkItem item)
+            {
+                item.Callback = null;
+                item.Context = null;
+                item.State = null;
+                if (_pool.Count < MaxPooledWorkItems)
+                {
+                    _pool.Add(item);
+                }
+            }
+
+            public void Enqueue(WorkItem item, WorkPriority priority)
+            {
+                // Checked under the same lock that CompleteAdding takes, so once the queue thread has
+                // seen that adding is complete, everything that was accepted is already in a lane
+                lock (_addingLock)
+                {
+                    if (_isAddingCompleted)
+                    {
+                        throw new InvalidOperationException("The synchronization context has been stopped.");
+                    }
+
+                    var lane = _lanes[(int)priority];
+                    item.EnqueuedTimestamp = Stopwatch.GetTimestamp();
+                    Interlocked.Increment(ref lane.Depth);
+                    lane.Items.Enqueue(item);
+                }
+
+                _workAvailable.Set();
+            }
+
+            public void CompleteAdding()
+            {
+                lock (_addingLock)
+                {
+                    _isAddingCompleted = true;
+                }
+
+                _workAvailable.Set();
+            }
+
+            public DesktopSynchronizationContextStatistics GetStatistics()
+            {
+                return new DesktopSynchronizationContextStatistics(
+                    _lanes[(int)WorkPriority.Input].GetStatistics(),
+                    _lanes[(int)WorkPriority.Render].GetStatistics(),
+                    _lanes[(int)WorkPriority.Background].GetStatistics());
+            }
+
+            // Takes from the highest-priority lane that has work, unless a lower-priority lane has
+            // already waited behind MaxItemsAheadOfWaitingLane items, in which case that lane goes next.
+            // Higher-priority work is only ever held back by one item per waiting lane.
+            private bool TryDequeue(out WorkItem item)
+            {
+                var chosen = -1;
+                for (var i = 0; i < _lanes.Length; i++)
+                {
+                    if (_lanes[i].Items.IsEmpty)
+                    {
+                        continue;
+                    }
+
+                    if (chosen < 0)
+                    {
+                        chosen = i;
+                    }
+                    else if (_lanes[i].ItemsAhead >= MaxItemsAheadOfWaitingLane)
+                    {
+                        chosen = i;
+                        break;
+                    }
+                }
+
+                if (chosen < 0 || !_lanes[chosen].Items.TryDequeue(out item))
+                {
+                    item = null;
+                    return false;
+                }
+
+                var lane = _lanes[chosen];
+                lane.ItemsAhead = 0;
+                Interlocked.Decrement(ref lane.Depth);
+                lane.RecordWait(Stopwatch.GetTimestamp() - item.EnqueuedTimestamp);
+
+                for (var i = chosen + 1; i < _lanes.Length; i++)
+                {
+                    if (!_lanes[i].Items.IsEmpty)
+                    {
+                        _lanes[i].ItemsAhead++;
+                    }
+                }
+
+                return true;
+            }
+
             private void ProcessQueue()
             {
-                while (!Queue.IsCompleted)
+                while (true)
                 {
-                    WorkItem item;
                     try
                     {
-                        item = Queue.Take(_cancellationToken);
+                        _workAvailable.Wait(_cancellationToken);
                     }
-                    catch (InvalidOperationException)
+                    catch (OperationCanceledException)
                     {
                         return;
                     }
-                    catch (OperationCanceledException)
+
+                    // Reset before draining, so anything enqueued after we find the lanes
+                    // empty sets the event again and we don't miss it
+                    _workAvailable.Reset();
+
+                    // Read before draining. If adding was already complete, nothing more can arrive,
+                    // so finding the lanes empty below means we're done.
+                    var isAddingCompleted = _isAddingCompleted;
+
+                    var processed = 0;
+                    while (processed < MaxItemsPerWake && TryDequeue(out var item))
+                    {
+                        Execute(item);
+                        processed++;
+                    }
+
+                    if (processed == MaxItemsPerWake)
+                    {
+                        // There may be more, so come straight back after checking for cancellation
+                        _workAvailable.Set();
+                    }
+                    else if (isAddingCompleted)
                     {
                         return;
                     }
+                }
+            }
 
-                    var current = Current;
-                    SetSynchronizationContext(item.Context);
+            private void Execute(WorkItem item)
+            {
+                var current = Current;
+                SetSynchronizationContext(item.Context);
 
-                    try
+                try
+                {
+                    ProcessWorkitemInline(item.Callback, item.State);
+                }
+                finally
+                {
+                    SetSynchronizationContext(current);
+
+                    if (item.IsSend)
                     {
-                        ProcessWorkitemInline(item.Callback, item.State);
+                        // The sender returns the item to the pool once it has woken up
+                        item.Completed.Set();
                     }
-                    finally
+                    else
                     {
-                        if (item.Completed != null)
-                        {
-                            item.Completed.Set();
-                        }
-
-                        SetSynchronizationContext(current);
+                        ReturnWorkItem(item);
                     }
                 }
             }
@@ -125,12 +323,104 @@ namespace WebWindows.Blazor
             }
         }
 
+        private class Lane
+        {
+            public readonly ConcurrentQueue<WorkItem> Items = new ConcurrentQueue<WorkItem>();
+            public int Depth;
+            public int ItemsAhead; // Only accessed on the queue thread
+            private long _processedCount;
+            private long _totalWaitTicks;
+            private long _maxWaitTicks;
+
+            // Only called from the queue thread
+            public void RecordWait(long waitTicks)
+            {
+                Interlocked.Increment(ref _processedCount);
+                Interlocked.Add(ref _totalWaitTicks, waitTicks);
+                if (waitTicks > Volatile.Read(ref _maxWaitTicks))
+                {
+                    Volatile.Write(ref _maxWaitTicks, waitTicks);
+                }
+            }
+
+            public WorkLaneStatistics GetStatistics()
+            {
+                return new WorkLaneStatistics(
+                    Volatile.Read(ref Depth),
+                    Interlocked.Read(ref _processedCount),
+                    TicksToTimeSpan(Interlocked.Read(ref _totalWaitTicks)),
+                    TicksToTimeSpan(Interlocked.Read(ref _maxWaitTicks)));
+            }
+
+            private static TimeSpan TicksToTimeSpan(long stopwatchTicks)
+                => TimeSpan.FromSeconds((double)stopwatchTicks / Stopwatch.Frequency);
+        }
+
         private class WorkItem
         {
             public SendOrPostCallback Callback;
             public object State;
             public SynchronizationContext Context;
             public ManualResetEventSlim Completed;
+            public bool IsSend;
+            public long EnqueuedTimestamp;
+        }
+    }
+
+    internal enum WorkPriority
+    {
+        // Lower values are processed first
+        Input = 0,
+        Render = 1,
+        Background = 2,
+    }
+
+    public readonly struct WorkLaneStatistics
+    {
+        /// <summary>
+        /// The number of work items currently waiting in the lane.
+        /// </summary>
+        public readonly int QueueDepth;
+
+        /// <summary>
+        /// The number of work items taken from the lane so far.
+        /// </summary>
+        public readonly long ProcessedCount;
+
+        /// <summary>
+        /// The total time work items spent waiting in the lane before being processed.
+        /// </summary>
+        public readonly TimeSpan TotalWaitTime;
+
+        /// <summary>
+        /// The longest time any single work item spent waiting in the lane.
+        /// </summary>
+        public readonly TimeSpan MaxWaitTime;
+
+        public WorkLaneStatistics(int queueDepth, long processedCount, TimeSpan totalWaitTime, TimeSpan maxWaitTime)
+        {
+            QueueDepth = queueDepth;
+            ProcessedCount = processedCount;
+            TotalWaitTime = totalWaitTime;
+            MaxWaitTime = maxWaitTime;
+        }
+
+        public TimeSpan AverageWaitTime => ProcessedCount == 0
+            ? TimeSpan.Zero
+            : TimeSpan.FromTicks(TotalWaitTime.Ticks / ProcessedCount);
+    }
+
+    public readonly struct DesktopSynchronizationContextStatistics
+    {
+        public readonly WorkLaneStatistics Input;
+        public readonly WorkLaneStatistics Render;
+        public readonly WorkLaneStatistics Background;
+
+        public DesktopSynchronizationContextStatistics(WorkLaneStatistics input, WorkLaneStatistics render, WorkLaneStatistics background)
+        {
+            Input = input;
+            Render = render;
+            Background = background;
         }
     }
 }
@@ -1,5 +1,8 @@
 ﻿using System;
+using System.Buffers;
 using System.Collections.Generic;
+using System.Diagnostics;
+using System.Runtime.InteropServices;
 using System.Text;
 using System.Text.Json;
 using System.Threading;
@@ -10,23 +13,141 @@ namespace WebWindows.Blazor
 {
     internal class IPC
     {
+        // A batch carries several messages in one frame. Its args are an array of [eventName, args] pairs.
+        private const string BatchEventName = "__batch";
+
         private readonly Dictionary<string, List<Action<object>>> _registrations = new Dictionary<string, List<Action<object>>>();
         private readonly WebWindow _webWindow;
+        private readonly bool _batchOutgoingMessages;
+        private readonly object _pendingSendsLock = new object();
+        private List<(string eventName, string argsJson)> _pendingSends = new List<(string eventName, string argsJson)>();
+        private bool _isFlushScheduled;
+        private readonly object _receiveChainLock = new object();
+        private Task _receiveChain = Task.CompletedTask;
+
+        [ThreadStatic] private static long _currentMessageReceivedTimestamp;
+
+        public IPC(WebWindow webWindow) : this(webWindow, batchOutgoingMessages: false)
+        {
+        }
 
-        public IPC(WebWindow webWindow)
+        public IPC(WebWindow webWindow, bool batchOutgoingMessages)
         {
             _webWindow = webWindow ?? throw new ArgumentNullException(nameof(webWindow));
+            _batchOutgoingMessages = batchOutgoingMessages;
             _webWindow.OnWebMessageReceived += HandleScriptNotify;
         }
 
+        /// <summary>
+        /// If set, all the callbacks for an incoming batch are run inside a single call to this,
+        /// so for example they can share one synchronization context turn.
+        /// </summary>
+        public Action<Action> BatchDispatcher { get; set; }
+
+        /// <summary>
+        /// While a callback registered with <see cref="On"/> is running, the <see cref="Stopwatch"/>
+        /// timestamp at which its message was received. Otherwise zero.
+        /// </summary>
+        public static long CurrentMessageReceivedTimestamp => _currentMessageReceivedTimestamp;
+
         public void Send(string eventName, params object[] args)
+        {
+            var argsJson = JsonSerializer.Serialize(args);
+            if (!_batchOutgoingMessages)
+            {
+                SendMessage($"{eventName}:{argsJson}");
+                return;
+            }
+
+            // Everything sent while a flush is pending or in progress goes out together in the
+            // next one. There's only ever one flush running, so messages stay in order.
+            lock (_pendingSendsLock)
+            {
+                _pendingSends.Add((eventName, argsJson));
+                if (_isFlushScheduled)
+                {
+                    return;
+                }
+
+                _isFlushScheduled = true;
+            }
+
+            ThreadPool.QueueUserWorkItem(_ => FlushPendingSends());
+        }
+
+        private void FlushPendingSends()
+        {
+            while (true)
+            {
+                List<(string eventName, string argsJson)> batch;
+                lock (_pendingSendsLock)
+                {
+                    if (_pendingSends.Count == 0)
+                    {
+                        _isFlushScheduled = false;
+                        return;
+                    }
+
+                    batch = _pendingSends;
+                    _pendingSends = new List<(string eventName, string argsJson)>();
+                }
+
+                if (batch.Count == 1)
+                {
+                    SendMessage($"{batch[0].eventName}:{batch[0].argsJson}");
+                }
+                else
+                {
+                    var message = new StringBuilder(BatchEventName).Append(":[");
+                    for (var i = 0; i < batch.Count; i++)
+                    {
+                        if (i > 0)
+                        {
+                            message.Append(',');
+                        }
+
+                        message.Append('[')
+                            .Append(JsonSerializer.Serialize(batch[i].eventName))
+                            .Append(',')
+                            .Append(batch[i].argsJson)
+                            .Append(']');
+                    }
+
+                    SendMessage(message.Append(']').ToString());
+                }
+            }
+        }
+
+        private void SendMessage(string message)
         {
             try
             {
-                _webWindow.Invoke(() =>
+                if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
                 {
-                    _webWindow.SendMessage($"{eventName}:{JsonSerializer.Serialize(args)}");
-                });
+                    // Strings are already UTF-16 and can be passed through as-is
+                    _webWindow.Invoke(() =>
+                    {
+                        _webWindow.SendMessage(message);
+                    });
+                }
+                else
+                {
+                    // Encode here rather than on the UI thread, and pass the length so the
+                    // native side doesn't have to scan for a terminator
+                    var buffer = ArrayPool<byte>.Shared.Rent(Encoding.UTF8.GetMaxByteCount(message.Length));
+                    try
+                    {
+                        var length = Encoding.UTF8.GetBytes(message, 0, message.Length, buffer, 0);
+                        _webWindow.Invoke(() =>
+                        {
+                            _webWindow.SendMessageUtf8(new ReadOnlySpan<byte>(buffer, 0, length));
+                        });
+                    }
+                    finally
+                    {
+                        ArrayPool<byte>.Shared.Return(buffer);
+                    }
+                }
             }
             catch (Exception ex)
             {
@@ -73,35 +194,97 @@ namespace WebWindows.Blazor
 
         private void HandleScriptNotify(object sender, string message)
         {
-            var value = message;
+            if (_webWindow.WebMessagesDeliveredOnBackgroundThread)
+            {
+                // We're already off the browser UI thread, and messages arrive one at a time in order.
+                // Handlers must not block, since nothing else arrives until they return.
+                HandleMessage(message);
+                return;
+            }
 
-            // Move off the browser UI thread
-            Task.Factory.StartNew(() =>
+            // Move off the browser UI thread. Each message is chained after the previous one
+            // so they are still handled in the order they were sent.
+            lock (_receiveChainLock)
             {
-                if (value.StartsWith("ipc:"))
-                {
-                    var spacePos = value.IndexOf(' ');
-                    var eventName = value.Substring(4, spacePos - 4);
-                    var argsJson = value.Substring(spacePos + 1);
-                    var args = JsonSerializer.Deserialize<object[]>(argsJson);
+                _receiveChain = _receiveChain.ContinueWith(
+                    (_, state) => HandleMessage((string)state),
+                    message,
+                    CancellationToken.None,
+                    TaskContinuationOptions.None,
+                    TaskScheduler.Default);
+            }
+        }
 
-                    Action<object>[] callbacksCopy;
-                    lock (_registrations)
-                    {
-                        if (!_registrations.TryGetValue(eventName, out var callbacks))
-                        {
-                            return;
-                        }
+        private void HandleMessage(string value)
+        {
+            if (value.StartsWith("ipc:"))
+            {
+                var receivedTimestamp = Stopwatch.GetTimestamp();
+                var spacePos = value.IndexOf(' ');
+                var eventName = value.Substring(4, spacePos - 4);
+                var argsJson = value.Substring(spacePos + 1);
 
-                        callbacksCopy = callbacks.ToArray();
+                if (eventName == BatchEventName)
+                {
+                    var entries = JsonSerializer.Deserialize<JsonElement[][]>(argsJson);
+                    var batchDispatcher = BatchDispatcher;
+                    if (batchDispatcher == null)
+                    {
+                        DispatchBatch(entries, receivedTimestamp);
                     }
-
-                    foreach (var callback in callbacksCopy)
+                    else
                     {
-                        callback(args);
+                        batchDispatcher(() => DispatchBatch(entries, receivedTimestamp));
                     }
                 }
-            });
+                else
+                {
+                    Dispatch(eventName, JsonSerializer.Deserialize<object[]>(argsJson), receivedTimestamp);
+                }
+            }
+        }
+
+        private void DispatchBatch(JsonElement[][] entries, long receivedTimestamp)
+        {
+            foreach (var entry in entries)
+            {
+                var eventName = entry[0].GetString();
+                var args = new object[entry[1].GetArrayLength()];
+                var index = 0;
+                foreach (var arg in entry[1].EnumerateArray())
+                {
+                    args[index++] = arg;
+                }
+
+                Dispatch(eventName, args, receivedTimestamp);
+            }
+        }
+
+        private void Dispatch(string eventName, object[] args, long receivedTimestamp)
+        {
+            Action<object>[] callbacksCopy;
+            lock (_registrations)
+            {
+                if (!_registrations.TryGetValue(eventName, out var callbacks))
+                {
+                    return;
+                }
+
+                callbacksCopy = callbacks.ToArray();
+            }
+
+            _currentMessageReceivedTimestamp = receivedTimestamp;
+            try
+            {
+                foreach (var callback in callbacksCopy)
+                {
+                    callback(args);
+                }
+            }
+            finally
+            {
+                _currentMessageReceivedTimestamp = 0;
+            }
         }
     }
 }
@@ -0,0 +1,159 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Text.Json;
+
+namespace WebWindows.Blazor
+{
+    /// <summary>
+    /// Follows each DOM event from the browser, through .NET, to the DOM update it causes, and
+    /// records how long each stage took in <see cref="LatencyStatistics"/>.
+    ///
+    /// The browser gives every event a correlation ID and passes it to DispatchEvent. Any render
+    /// batch produced while that event is being dispatched is tagged with the ID, and the browser
+    /// reports back once it has applied the batch. The .NET stages are measured with Stopwatch
+    /// and the browser stages with performance.now(), so no stage compares timestamps from
+    /// different clocks. Whatever is left over is the time spent in transit.
+    /// </summary>
+    internal class InteractionLatencyTracker
+    {
+        // Interactions whose render batch has been sent, but not yet applied by the browser
+        private readonly Dictionary<long, Interaction> _awaitingBrowser = new Dictionary<long, Interaction>();
+
+        // Only accessed on the synchronization context
+        private long _dispatchingMessageReceivedTimestamp;
+        private Interaction _current;
+
+        public InteractionLatencyTracker(IPC ipc)
+        {
+            ipc.On("OnInteractionCompleted", OnInteractionCompleted);
+        }
+
+        /// <summary>
+        /// Called on the synchronization context just before dispatching an interop call from the browser.
+        /// </summary>
+        public void BeginDispatch(long messageReceivedTimestamp)
+        {
+            _dispatchingMessageReceivedTimestamp = messageReceivedTimestamp;
+        }
+
+        public void EndDispatch()
+        {
+            _dispatchingMessageReceivedTimestamp = 0;
+        }
+
+        /// <summary>
+        /// Called when dispatching a DOM event. Any batch rendered before <see cref="EndInteraction"/>
+        /// is attributed to it.
+        /// </summary>
+        public void BeginInteraction(long interactionId)
+        {
+            if (interactionId == 0 || _dispatchingMessageReceivedTimestamp == 0)
+            {
+                return;
+            }
+
+            _current = new Interaction
+            {
+                Id = interactionId,
+                MessageReceivedTimestamp = _dispatchingMessageReceivedTimestamp,
+                DispatchedTimestamp = Stopwatch.GetTimestamp(),
+            };
+        }
+
+        public void EndInteraction()
+        {
+            _current = null;
+        }
+
+        /// <summary>
+        /// Called before serializing a render batch.
+        /// </summary>
+        /// <returns>The ID to tag the batch with, or 0 if it isn't the first batch for an interaction.</returns>
+        public long BeginRender()
+        {
+            if (_current == null || _current.RenderStartedTimestamp != 0)
+            {
+                return 0;
+            }
+
+            _current.RenderStartedTimestamp = Stopwatch.GetTimestamp();
+            return _current.Id;
+        }
+
+        /// <summary>
+        /// Called once the batch returned by <see cref="BeginRender"/> has been queued to send.
+        /// </summary>
+        public void EndRender(long interactionId)
+        {
+            if (interactionId == 0)
+            {
+                return;
+            }
+
+            _current.RenderSentTimestamp = Stopwatch.GetTimestamp();
+            lock (_awaitingBrowser)
+            {
+                _awaitingBrowser[interactionId] = _current;
+            }
+        }
+
+        private void OnInteractionCompleted(object args)
+        {
+            var argsArray = (object[])args;
+            var interactionId = ((JsonElement)argsArray[0]).GetInt64();
+
+            Interaction interaction;
+            lock (_awaitingBrowser)
+            {
+                if (!_awaitingBrowser.Remove(interactionId, out interaction))
+                {
+                    return;
+                }
+
+                // The browser applies batches in order, so it won't report anything earlier than this
+                if (_awaitingBrowser.Count > 0)
+                {
+                    var stale = new List<long>();
+                    foreach (var id in _awaitingBrowser.Keys)
+                    {
+                        if (id < interactionId)
+                        {
+                            stale.Add(id);
+                        }
+                    }
+
+                    stale.ForEach(id => _awaitingBrowser.Remove(id));
+                }
+            }
+
+            var eventToSend = TimeSpan.FromMilliseconds(((JsonElement)argsArray[1]).GetDouble());
+            var browserApply = TimeSpan.FromMilliseconds(((JsonElement)argsArray[2]).GetDouble());
+            var endToEnd = TimeSpan.FromMilliseconds(((JsonElement)argsArray[3]).GetDouble());
+            var dispatchQueue = ElapsedBetween(interaction.MessageReceivedTimestamp, interaction.DispatchedTimestamp);
+            var handler = ElapsedBetween(interaction.DispatchedTimestamp, interaction.RenderStartedTimestamp);
+            var renderAndSend = ElapsedBetween(interaction.RenderStartedTimestamp, interaction.RenderSentTimestamp);
+            var transit = endToEnd - eventToSend - dispatchQueue - handler - renderAndSend - browserApply;
+
+            LatencyStatistics.Record(LatencyStage.BrowserEventToSend, eventToSend);
+            LatencyStatistics.Record(LatencyStage.DispatchQueue, dispatchQueue);
+            LatencyStatistics.Record(LatencyStage.Handler, handler);
+            LatencyStatistics.Record(LatencyStage.RenderAndSend, renderAndSend);
+            LatencyStatistics.Record(LatencyStage.BrowserApply, browserApply);
+            LatencyStatistics.Record(LatencyStage.Transit, transit < TimeSpan.Zero ? TimeSpan.Zero : transit);
+            LatencyStatistics.Record(LatencyStage.EndToEnd, endToEnd);
+        }
+
+        private static TimeSpan ElapsedBetween(long startTimestamp, long endTimestamp)
+            => TimeSpan.FromSeconds((double)(endTimestamp - startTimestamp) / Stopwatch.Frequency);
+
+        private class Interaction
+        {
+            public long Id;
+            public long MessageReceivedTimestamp;
+            public long DispatchedTimestamp;
+            public long RenderStartedTimestamp;
+            public long RenderSentTimestamp;
+        }
+    }
+}
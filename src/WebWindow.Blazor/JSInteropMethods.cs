@@ -11,14 +11,28 @@ namespace WebWindows.Blazor
     public static class JSInteropMethods
     {
         [JSInvokable(nameof(DispatchEvent))]
-        public static async Task DispatchEvent(WebEventDescriptor eventDescriptor, string eventArgsJson)
+        public static async Task DispatchEvent(WebEventDescriptor eventDescriptor, string eventArgsJson, long interactionId)
         {
             var webEvent = WebEventData.Parse(eventDescriptor, eventArgsJson);
             var renderer = ComponentsDesktop.DesktopRenderer;
-            await renderer.DispatchEventAsync(
-                webEvent.EventHandlerId,
-                webEvent.EventFieldInfo,
-                webEvent.EventArgs);
+            var latencyTracker = ComponentsDesktop.InteractionLatencyTracker;
+
+            // Only batches rendered synchronously as part of handling the event are attributed to it
+            Task dispatchTask;
+            latencyTracker?.BeginInteraction(interactionId);
+            try
+            {
+                dispatchTask = renderer.DispatchEventAsync(
+                    webEvent.EventHandlerId,
+                    webEvent.EventFieldInfo,
+                    webEvent.EventArgs);
+            }
+            finally
+            {
+                latencyTracker?.EndInteraction();
+            }
+
+            await dispatchTask;
         }
 
         [JSInvokable(nameof(NotifyLocationChanged))]
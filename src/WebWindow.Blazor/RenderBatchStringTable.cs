@@ -0,0 +1,148 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Threading;
+
+namespace WebWindows.Blazor
+{
+    /// <summary>
+    /// A session-lifetime string dictionary shared by the .NET render batch writer and the
+    /// JS render batch reader. Once a string has been assigned a slot, later batches refer to it
+    /// by slot number instead of re-encoding it.
+    ///
+    /// The .NET side is authoritative: it decides which slot each string occupies and which
+    /// entries get evicted. Every batch carries the list of (slot, string) assignments it makes,
+    /// so the JS side only ever overwrites slots in the order it is told to and the two tables
+    /// can't drift apart.
+    /// </summary>
+    internal class RenderBatchStringTable
+    {
+        public const int DefaultCapacity = 4096;
+        public const int DefaultMaxStringLength = 128;
+
+        private readonly Dictionary<string, LinkedListNode<Entry>> _entries;
+        private readonly LinkedList<Entry> _recency = new LinkedList<Entry>(); // Most recently used first
+        private readonly int _capacity;
+        private readonly int _maxStringLength;
+        private int _batchId;
+        private int _isResetRequested;
+
+        public RenderBatchStringTable(int capacity, int maxStringLength)
+        {
+            if (capacity <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(capacity));
+            }
+
+            _capacity = capacity;
+            _maxStringLength = maxStringLength;
+            _entries = new Dictionary<string, LinkedListNode<Entry>>(capacity);
+        }
+
+        public int Count => _entries.Count;
+
+        /// <summary>
+        /// Can be called from any thread when the recipient's table may no longer match this one,
+        /// e.g., because the page reloaded or a frame failed to apply. The table is emptied before
+        /// the next batch is written.
+        /// </summary>
+        public void RequestReset()
+        {
+            Interlocked.Exchange(ref _isResetRequested, 1);
+        }
+
+        /// <summary>
+        /// Must be called before writing each batch, on the thread that writes batches.
+        /// </summary>
+        /// <returns>True if the table was emptied, in which case the recipient must empty its own table before reading the batch.</returns>
+        public bool TryApplyRequestedReset()
+        {
+            if (Interlocked.Exchange(ref _isResetRequested, 0) == 0)
+            {
+                return false;
+            }
+
+            _entries.Clear();
+            _recency.Clear();
+            return true;
+        }
+
+        /// <summary>
+        /// Must be called before writing each batch. Entries used by the current batch are
+        /// never evicted while that batch is being written, because the recipient applies all
+        /// of a batch's slot assignments before reading any of its frames.
+        /// </summary>
+        public void BeginBatch()
+        {
+            _batchId++;
+        }
+
+        /// <summary>
+        /// Gets the slot for <paramref name="value"/>, assigning one if necessary.
+        /// </summary>
+        /// <returns>False if the value should be written into the batch-local string table instead.</returns>
+        public bool TryGetSlot(string value, out int slot, out bool isNewAssignment)
+        {
+            if (value.Length > _maxStringLength)
+            {
+                slot = -1;
+                isNewAssignment = false;
+                return false;
+            }
+
+            if (_entries.TryGetValue(value, out var node))
+            {
+                node.Value.LastBatchId = _batchId;
+                if (node != _recency.First)
+                {
+                    _recency.Remove(node);
+                    _recency.AddFirst(node);
+                }
+
+                slot = node.Value.Slot;
+                isNewAssignment = false;
+                return true;
+            }
+
+            if (_entries.Count < _capacity)
+            {
+                node = new LinkedListNode<Entry>(new Entry { Slot = _entries.Count });
+            }
+            else
+            {
+                node = _recency.Last;
+                if (node.Value.LastBatchId == _batchId)
+                {
+                    // Everything in the table is in use by this batch, so there's nothing we can evict
+                    slot = -1;
+                    isNewAssignment = false;
+                    return false;
+                }
+
+                _recency.RemoveLast();
+                _entries.Remove(node.Value.Value);
+            }
+
+            node.Value.Value = value;
+            node.Value.LastBatchId = _batchId;
+            _recency.AddFirst(node);
+            _entries.Add(value, node);
+
+            slot = node.Value.Slot;
+            isNewAssignment = true;
+            return true;
+        }
+
+        /// <summary>
+        /// Slot references share the int32 string index field with batch-local indices.
+        /// Non-negative values are batch-local, -1 is null, and -2 downwards are slots.
+        /// </summary>
+        public static int EncodeSlotReference(int slot) => -2 - slot;
+
+        private class Entry
+        {
+            public string Value;
+            public int Slot;
+            public int LastBatchId;
+        }
+    }
+}
@@ -0,0 +1,186 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Text.Json;
+using System.Threading.Tasks;
+
+namespace WebWindows.Blazor
+{
+    /// <summary>
+    /// Holds back render batches while the browser is still applying an earlier frame, and
+    /// sends everything that accumulated in the meantime as a single message once the browser
+    /// acknowledges that frame. The browser applies each message inside a requestAnimationFrame
+    /// callback, so DOM work happens at most once per display frame.
+    /// </summary>
+    internal class RenderFramePacer
+    {
+        private readonly IPC _ipc;
+        private readonly int _rendererId;
+        private readonly RenderBatchStringTable _persistentStrings;
+        private readonly object _lock = new object();
+        private List<string> _pendingBatches = new List<string>();
+        private List<int> _pendingPersistentStringResets = new List<int>(); // Indices into _pendingBatches
+        private List<long> _pendingInteractionIds = new List<long>();
+        private List<TaskCompletionSource<object>> _pendingCompletions = new List<TaskCompletionSource<object>>();
+        private List<TaskCompletionSource<object>> _inFlightCompletions = new List<TaskCompletionSource<object>>();
+        private bool _isFrameInFlight;
+        private long _framesSent;
+        private long _batchesMerged;
+        private long _framesDropped;
+
+        /// <param name="persistentStrings">The table the batches are written with, or null if they don't use one.</param>
+        public RenderFramePacer(IPC ipc, int rendererId, RenderBatchStringTable persistentStrings)
+        {
+            _ipc = ipc ?? throw new ArgumentNullException(nameof(ipc));
+            _rendererId = rendererId;
+            _persistentStrings = persistentStrings;
+            _ipc.On("OnRenderFrameCompleted", OnFrameCompleted);
+        }
+
+        public RenderFrameStatistics Statistics
+        {
+            get
+            {
+                lock (_lock)
+                {
+                    return new RenderFrameStatistics(_framesSent, _batchesMerged, _framesDropped);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Queues a batch for the next frame.
+        /// </summary>
+        /// <param name="batchBase64">The serialized batch.</param>
+        /// <param name="interactionId">The interaction that caused the batch, or 0.</param>
+        /// <param name="resetsPersistentStrings">True if the persistent string table was emptied before writing the batch.</param>
+        /// <returns>A task that completes when the browser has applied the batch.</returns>
+        public Task EnqueueBatch(string batchBase64, long interactionId, bool resetsPersistentStrings)
+        {
+            var completion = new TaskCompletionSource<object>(TaskCreationOptions.RunContinuationsAsynchronously);
+            lock (_lock)
+            {
+                if (resetsPersistentStrings)
+                {
+                    _pendingPersistentStringResets.Add(_pendingBatches.Count);
+                }
+
+                _pendingBatches.Add(batchBase64);
+                _pendingCompletions.Add(completion);
+                if (interactionId != 0)
+                {
+                    _pendingInteractionIds.Add(interactionId);
+                }
+
+                if (_isFrameInFlight)
+                {
+                    // It will go out when the current frame is acknowledged
+                    return completion.Task;
+                }
+            }
+
+            Flush();
+            return completion.Task;
+        }
+
+        private void OnFrameCompleted(object args)
+        {
+            var argsArray = (object[])args;
+            var framesDropped = ((JsonElement)argsArray[0]).GetInt32();
+            var error = argsArray.Length > 1 && argsArray[1] is JsonElement errorElement && errorElement.ValueKind == JsonValueKind.String
+                ? errorElement.GetString()
+                : null;
+
+            List<TaskCompletionSource<object>> completed;
+            lock (_lock)
+            {
+                _framesDropped += framesDropped;
+                _isFrameInFlight = false;
+                completed = _inFlightCompletions;
+                _inFlightCompletions = new List<TaskCompletionSource<object>>();
+            }
+
+            // Fault the frame's batches so the renderer reports the error, but carry on with later
+            // frames, since the browser has acknowledged this one and is ready for the next
+            var exception = error == null ? null : new InvalidOperationException($"Error applying render batch: {error}");
+            if (exception != null)
+            {
+                // The browser may have stopped partway through the frame, so its string table
+                // can't be trusted to match ours any more
+                _persistentStrings?.RequestReset();
+            }
+
+            foreach (var completion in completed)
+            {
+                if (exception == null)
+                {
+                    completion.TrySetResult(null);
+                }
+                else
+                {
+                    completion.TrySetException(exception);
+                }
+            }
+
+            Flush();
+        }
+
+        private void Flush()
+        {
+            string[] batches;
+            long[] interactionIds;
+            int[] persistentStringResets;
+            lock (_lock)
+            {
+                if (_isFrameInFlight || _pendingBatches.Count == 0)
+                {
+                    return;
+                }
+
+                batches = _pendingBatches.ToArray();
+                _pendingBatches.Clear();
+                interactionIds = _pendingInteractionIds.ToArray();
+                _pendingInteractionIds.Clear();
+                persistentStringResets = _pendingPersistentStringResets.ToArray();
+                _pendingPersistentStringResets.Clear();
+
+                // Swap rather than copy, since the in-flight list is always empty at this point
+                var inFlight = _inFlightCompletions;
+                _inFlightCompletions = _pendingCompletions;
+                _pendingCompletions = inFlight;
+
+                _isFrameInFlight = true;
+                _framesSent++;
+                _batchesMerged += batches.Length - 1;
+            }
+
+            _ipc.Send("JS.RenderFrame", _rendererId, _persistentStrings != null, batches, interactionIds, persistentStringResets);
+        }
+    }
+
+    public readonly struct RenderFrameStatistics
+    {
+        /// <summary>
+        /// The number of frames sent to the browser.
+        /// </summary>
+        public readonly long FramesSent;
+
+        /// <summary>
+        /// The number of render batches that were combined into a frame along with an earlier
+        /// batch, rather than being sent on their own.
+        /// </summary>
+        public readonly long BatchesMerged;
+
+        /// <summary>
+        /// The number of display frames that passed between a frame arriving in the browser
+        /// and it being applied to the DOM.
+        /// </summary>
+        public readonly long FramesDropped;
+
+        public RenderFrameStatistics(long framesSent, long batchesMerged, long framesDropped)
+        {
+            FramesSent = framesSent;
+            BatchesMerged = batchesMerged;
+            FramesDropped = framesDropped;
+        }
+    }
+}
@@ -6,6 +6,7 @@ using System;
 using System.Collections.Generic;
 using System.IO;
 using System.Text;
+using WebWindows.Blazor;
 
 namespace Microsoft.AspNetCore.Components.Server.Circuits
 {
@@ -27,6 +28,10 @@ namespace Microsoft.AspNetCore.Components.Server.Circuits
     ///  * We only serialize the data that the JS side will need. For example, we don't
     ///    emit frame sequence numbers, or any representation of nonstring attribute
     ///    values, or component instances, etc.
+    ///  * Optionally, strings can be written by reference to a session-lifetime
+    ///    <see cref="RenderBatchStringTable"/>. The slot assignments made by each batch are
+    ///    written as (slot, string index) int pairs followed by a count, immediately before
+    ///    the trailing offsets, so the recipient can find them by counting back from the end.
     ///    
     /// We don't have or need a .NET reader for this format. We only read it from JS code.
     /// </summary>
@@ -35,22 +40,38 @@ namespace Microsoft.AspNetCore.Components.Server.Circuits
         private readonly ArrayBuilder<string> _strings;
         private readonly Dictionary<string, int> _deduplicatedStringIndices;
         private readonly BinaryWriter _binaryWriter;
+        private readonly RenderBatchStringTable _persistentStrings;
+        private readonly ArrayBuilder<int> _slotAssignments;
 
         public RenderBatchWriter(Stream output, bool leaveOpen)
+            : this(output, leaveOpen, persistentStrings: null)
+        {
+        }
+
+        public RenderBatchWriter(Stream output, bool leaveOpen, RenderBatchStringTable persistentStrings)
         {
             _strings = new ArrayBuilder<string>();
             _deduplicatedStringIndices = new Dictionary<string, int>();
             _binaryWriter = new BinaryWriter(output, Encoding.UTF8, leaveOpen);
+            _persistentStrings = persistentStrings;
+            _slotAssignments = persistentStrings == null ? null : new ArrayBuilder<int>();
         }
 
         public void Write(in RenderBatch renderBatch)
         {
+            _persistentStrings?.BeginBatch();
+
             var updatedComponentsOffset = Write(renderBatch.UpdatedComponents);
             var referenceFramesOffset = Write(renderBatch.ReferenceFrames);
             var disposedComponentIdsOffset = Write(renderBatch.DisposedComponentIDs);
             var disposedEventHandlerIdsOffset = Write(renderBatch.DisposedEventHandlerIDs);
             var stringTableOffset = WriteStringTable();
 
+            if (_persistentStrings != null)
+            {
+                WriteSlotAssignments();
+            }
+
             _binaryWriter.Write(updatedComponentsOffset);
             _binaryWriter.Write(referenceFramesOffset);
             _binaryWriter.Write(disposedComponentIdsOffset);
@@ -109,7 +130,7 @@ namespace Microsoft.AspNetCore.Components.Server.Circuits
             // whichever one applies to the edit type
             _binaryWriter.Write(edit.ReferenceFrameIndex);
 
-            WriteString(edit.RemovedAttributeName, allowDeduplication: true);
+            WriteString(edit.RemovedAttributeName, allowDeduplication: true, allowPersistence: true);
         }
 
         int Write(in ArrayRange<RenderTreeFrame> frames)
@@ -141,7 +162,7 @@ namespace Microsoft.AspNetCore.Components.Server.Circuits
             switch (frame.FrameType)
             {
                 case RenderTreeFrameType.Attribute:
-                    WriteString(frame.AttributeName, allowDeduplication: true);
+                    WriteString(frame.AttributeName, allowDeduplication: true, allowPersistence: true);
                     if (frame.AttributeValue is bool boolValue)
                     {
                         // Encoding the bool as either "" or null is pretty odd, but avoids
@@ -151,12 +172,14 @@ namespace Microsoft.AspNetCore.Components.Server.Circuits
                         // or something else, we'll need a different encoding mechanism. Since there
                         // would never be more than (say) 2^28 (268 million) distinct string table
                         // entries, we could use the first 4 bits to encode the value type.
-                        WriteString(boolValue ? string.Empty : null, allowDeduplication: true);
+                        WriteString(boolValue ? string.Empty : null, allowDeduplication: true, allowPersistence: true);
                     }
                     else
                     {
                         var attributeValueString = frame.AttributeValue as string;
-                        WriteString(attributeValueString, allowDeduplication: string.IsNullOrEmpty(attributeValueString));
+                        // Attribute values such as CSS class names tend to repeat across batches even though
+                        // they aren't deduplicated within one, so they're worth persisting if short enough
+                        WriteString(attributeValueString, allowDeduplication: string.IsNullOrEmpty(attributeValueString), allowPersistence: true);
                     }
                     _binaryWriter.Write(frame.AttributeEventHandlerId); // 8 bytes
                     break;
@@ -173,7 +196,7 @@ namespace Microsoft.AspNetCore.Components.Server.Circuits
                     break;
                 case RenderTreeFrameType.Element:
                     _binaryWriter.Write(frame.ElementSubtreeLength);
-                    WriteString(frame.ElementName, allowDeduplication: true);
+                    WriteString(frame.ElementName, allowDeduplication: true, allowPersistence: true);
                     WritePadding(_binaryWriter, 8);
                     break;
                 case RenderTreeFrameType.ElementReferenceCapture:
@@ -229,12 +252,25 @@ namespace Microsoft.AspNetCore.Components.Server.Circuits
             return startPos;
         }
 
-        void WriteString(string value, bool allowDeduplication)
+        void WriteString(string value, bool allowDeduplication, bool allowPersistence = false)
         {
             if (value == null)
             {
                 _binaryWriter.Write(-1);
             }
+            else if (allowPersistence
+                && _persistentStrings != null
+                && _persistentStrings.TryGetSlot(value, out var slot, out var isNewAssignment))
+            {
+                if (isNewAssignment)
+                {
+                    _slotAssignments.Append(slot);
+                    _slotAssignments.Append(_strings.Count);
+                    _strings.Append(value);
+                }
+
+                _binaryWriter.Write(RenderBatchStringTable.EncodeSlotReference(slot));
+            }
             else
             {
                 int stringIndex;
@@ -277,6 +313,19 @@ namespace Microsoft.AspNetCore.Components.Server.Circuits
             return locationsStartPos;
         }
 
+        void WriteSlotAssignments()
+        {
+            // Each entry is a (slot, string table index) pair
+            var count = _slotAssignments.Count;
+            var buffer = _slotAssignments.Buffer;
+            for (var i = 0; i < count; i++)
+            {
+                _binaryWriter.Write(buffer[i]);
+            }
+
+            _binaryWriter.Write(count / 2);
+        }
+
         static void WritePadding(BinaryWriter writer, int numBytes)
         {
             while (numBytes >= 4)
@@ -295,6 +344,7 @@ namespace Microsoft.AspNetCore.Components.Server.Circuits
         public void Dispose()
         {
             _strings.Dispose();
+            _slotAssignments?.Dispose();
             _binaryWriter.Dispose();
         }
     }
@@ -1,4 +1,6 @@
 #include "WebWindow.h"
+#include "WebWindow.Latency.h"
+#include <cstdint>
 
 #ifdef _WIN32
 # define EXPORTED __declspec(dllexport)
@@ -35,11 +37,21 @@ extern "C"
 		delete instance;
 	}
 
+	EXPORTED void WebWindow_DestroyOnUiThread(WebWindow* instance)
+	{
+		WebWindow::DestroyOnUiThread(instance);
+	}
+
 	EXPORTED void WebWindow_SetTitle(WebWindow* instance, AutoString title)
 	{
 		instance->SetTitle(title);
 	}
 
+	EXPORTED void WebWindow_SetTitleUtf8(WebWindow* instance, const uint8_t* utf8, size_t length)
+	{
+		instance->SetTitleUtf8(std::string_view((const char*)utf8, length));
+	}
+
 	EXPORTED void WebWindow_Show(WebWindow* instance)
 	{
 		instance->Show();
@@ -50,6 +62,16 @@ extern "C"
 		instance->WaitForExit();
 	}
 
+	EXPORTED int WebWindow_Pump(WebWindow* instance, int maxMillis, int* nextTimeoutMillis)
+	{
+		return instance->Pump(maxMillis, nextTimeoutMillis);
+	}
+
+	EXPORTED int WebWindow_GetEventLoopFd(WebWindow* instance)
+	{
+		return instance->GetEventLoopFd();
+	}
+
 	EXPORTED void WebWindow_ShowMessage(WebWindow* instance, AutoString title, AutoString body, unsigned int type)
 	{
 		instance->ShowMessage(title, body, type);
@@ -65,6 +87,11 @@ extern "C"
 		instance->NavigateToString(content);
 	}
 
+	EXPORTED void WebWindow_NavigateToStringUtf8(WebWindow* instance, const uint8_t* utf8, size_t length)
+	{
+		instance->NavigateToStringUtf8(std::string_view((const char*)utf8, length));
+	}
+
 	EXPORTED void WebWindow_NavigateToUrl(WebWindow* instance, AutoString url)
 	{
 		instance->NavigateToUrl(url);
@@ -75,6 +102,47 @@ extern "C"
 		instance->SendMessage(message);
 	}
 
+	EXPORTED void WebWindow_SendMessageUtf8(WebWindow* instance, const uint8_t* utf8, size_t length)
+	{
+		instance->SendMessageUtf8(std::string_view((const char*)utf8, length));
+	}
+
+	EXPORTED void WebWindow_EvaluateScript(WebWindow* instance, const uint8_t* utf8Script, size_t length, EvaluateScriptCallback callback, void* userData)
+	{
+		instance->EvaluateScript(std::string_view((const char*)utf8Script, length), callback, userData);
+	}
+
+	EXPORTED int WebWindow_CaptureSnapshot(WebWindow* instance, int x, int y, int width, int height, int targetWidth, int targetHeight,
+		unsigned char* buffer, int stride, SnapshotCapturedCallback callback, void* userData)
+	{
+		return instance->CaptureSnapshot(x, y, width, height, targetWidth, targetHeight, buffer, stride, callback, userData);
+	}
+
+	EXPORTED void WebWindow_EnableLatencyTracking(int enabled)
+	{
+		LatencyStatistics::Enable(enabled);
+	}
+
+	EXPORTED void WebWindow_RecordLatency(int stage, int64_t micros)
+	{
+		LatencyStatistics::Record(stage, micros);
+	}
+
+	EXPORTED int WebWindow_GetLatencyPercentiles(int stage, LatencyPercentiles* percentiles)
+	{
+		return LatencyStatistics::GetPercentiles(stage, percentiles);
+	}
+
+	EXPORTED void WebWindow_DumpLatencyStatistics()
+	{
+		LatencyStatistics::Dump(stderr);
+	}
+
+	EXPORTED void WebWindow_ResetLatencyStatistics()
+	{
+		LatencyStatistics::Reset();
+	}
+
 	EXPORTED void WebWindow_AddCustomScheme(WebWindow* instance, AutoString scheme, WebResourceRequestedCallback requestHandler)
 	{
 		instance->AddCustomScheme(scheme, requestHandler);
@@ -134,4 +202,39 @@ extern "C"
 	{
 		instance->SetIconFile(filename);
 	}
+
+	EXPORTED int WebWindow_GetMemoryUsage(WebWindow* instance, MemoryUsage* usage)
+	{
+		return instance->GetMemoryUsage(usage);
+	}
+
+	EXPORTED void WebWindow_GetWebProcesses(WebWindow* instance, GetWebProcessesCallback callback)
+	{
+		instance->GetWebProcesses(callback);
+	}
+
+	EXPORTED void WebWindow_TrimMemory(WebWindow* instance, int level)
+	{
+		instance->TrimMemory(level);
+	}
+
+	EXPORTED int WebWindow_SetWebProcessMemoryLimit(WebWindow* instance, int megabytes)
+	{
+		return instance->SetWebProcessMemoryLimit(megabytes);
+	}
+
+	EXPORTED int WebWindow_EnableMemoryPressureMonitoring(WebWindow* instance, MemoryPressureCallback callback)
+	{
+		return instance->EnableMemoryPressureMonitoring(callback);
+	}
+
+	EXPORTED int WebWindow_EnableHeadlessMode(WebWindow* instance, int width, int height)
+	{
+		return instance->EnableHeadlessMode(width, height);
+	}
+
+	EXPORTED int WebWindow_EnableBackgroundMessageDelivery(WebWindow* instance)
+	{
+		return instance->EnableBackgroundMessageDelivery();
+	}
 }
@@ -0,0 +1,178 @@
+#include "WebWindow.Latency.h"
+#include <atomic>
+#include <chrono>
+
+// Values below SubBucketCount microseconds get a bucket each. Above that, each power of two is
+// split into SubBucketCount / 2 buckets, so percentiles are accurate to within about 3%.
+static const int SubBucketBits = 6;
+static const int SubBucketCount = 1 << SubBucketBits;
+static const int HalfSubBucketCount = SubBucketCount / 2;
+static const int MaxValueBits = 40; // About 12 days
+static const int BucketCount = SubBucketCount + (MaxValueBits - SubBucketBits) * HalfSubBucketCount;
+
+static const char* StageNames[LatencyStageCount] =
+{
+	"BrowserEventToSend",
+	"NativeMessageDelivery",
+	"DispatchQueue",
+	"Handler",
+	"RenderAndSend",
+	"BrowserApply",
+	"Transit",
+	"EndToEnd",
+};
+
+struct Histogram
+{
+	std::atomic<uint64_t> buckets[BucketCount];
+	std::atomic<int64_t> max;
+};
+
+static std::atomic<bool> latencyTrackingEnabled(false);
+static Histogram histograms[LatencyStageCount];
+
+static int HighestBit(uint64_t value)
+{
+	int bit = 0;
+	while (value >>= 1)
+	{
+		bit++;
+	}
+	return bit;
+}
+
+static int BucketIndex(uint64_t micros)
+{
+	if (micros < (uint64_t)SubBucketCount)
+	{
+		return (int)micros;
+	}
+
+	int highestBit = HighestBit(micros);
+	if (highestBit >= MaxValueBits)
+	{
+		return BucketCount - 1;
+	}
+
+	int shift = highestBit - SubBucketBits + 1;
+	int subBucket = (int)(micros >> shift) - HalfSubBucketCount;
+	return SubBucketCount + (highestBit - SubBucketBits) * HalfSubBucketCount + subBucket;
+}
+
+// Reports the middle of the bucket's range
+static int64_t BucketValue(int index)
+{
+	if (index < SubBucketCount)
+	{
+		return index;
+	}
+
+	int octave = (index - SubBucketCount) / HalfSubBucketCount;
+	int subBucket = (index - SubBucketCount) % HalfSubBucketCount + HalfSubBucketCount;
+	int shift = octave + 1;
+	return ((int64_t)subBucket << shift) + ((int64_t)1 << shift) / 2;
+}
+
+void LatencyStatistics::Enable(bool enabled)
+{
+	latencyTrackingEnabled = enabled;
+}
+
+bool LatencyStatistics::IsEnabled()
+{
+	return latencyTrackingEnabled.load(std::memory_order_relaxed);
+}
+
+int64_t LatencyStatistics::NowMicros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LatencyStatistics::Record(int stage, int64_t micros)
+{
+	if (stage < 0 || stage >= LatencyStageCount)
+	{
+		return;
+	}
+
+	if (micros < 0)
+	{
+		micros = 0;
+	}
+
+	Histogram& histogram = histograms[stage];
+	histogram.buckets[BucketIndex((uint64_t)micros)].fetch_add(1, std::memory_order_relaxed);
+
+	int64_t max = histogram.max.load(std::memory_order_relaxed);
+	while (micros > max && !histogram.max.compare_exchange_weak(max, micros, std::memory_order_relaxed))
+	{
+	}
+}
+
+bool LatencyStatistics::GetPercentiles(int stage, LatencyPercentiles* percentiles)
+{
+	if (stage < 0 || stage >= LatencyStageCount)
+	{
+		return false;
+	}
+
+	// Take a copy so the percentiles are consistent with each other even if recording continues
+	Histogram& histogram = histograms[stage];
+	uint64_t counts[BucketCount];
+	uint64_t total = 0;
+	for (int i = 0; i < BucketCount; i++)
+	{
+		counts[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+		total += counts[i];
+	}
+
+	*percentiles = {};
+	percentiles->count = (int64_t)total;
+	percentiles->maxMicros = histogram.max.load(std::memory_order_relaxed);
+	if (total == 0)
+	{
+		return true;
+	}
+
+	const double fractions[] = { 0.50, 0.95, 0.99 };
+	int64_t* results[] = { &percentiles->p50Micros, &percentiles->p95Micros, &percentiles->p99Micros };
+	uint64_t seen = 0;
+	int next = 0;
+	for (int i = 0; i < BucketCount && next < 3; i++)
+	{
+		seen += counts[i];
+		while (next < 3 && seen >= (uint64_t)(fractions[next] * total + 0.5))
+		{
+			*results[next++] = BucketValue(i);
+		}
+	}
+
+	return true;
+}
+
+void LatencyStatistics::Dump(FILE* output)
+{
+	fprintf(output, "%-24s %10s %10s %10s %10s %10s\n", "Stage (microseconds)", "Count", "p50", "p95", "p99", "Max");
+	for (int stage = 0; stage < LatencyStageCount; stage++)
+	{
+		LatencyPercentiles percentiles;
+		GetPercentiles(stage, &percentiles);
+		fprintf(output, "%-24s %10lld %10lld %10lld %10lld %10lld\n", StageNames[stage],
+			(long long)percentiles.count, (long long)percentiles.p50Micros, (long long)percentiles.p95Micros,
+			(long long)percentiles.p99Micros, (long long)percentiles.maxMicros);
+	}
+	fflush(output);
+}
+
+void LatencyStatistics::Reset()
+{
+	for (Histogram& histogram : histograms)
+	{
+		for (auto& bucket : histogram.buckets)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+		histogram.max.store(0, std::memory_order_relaxed);
+	}
+}
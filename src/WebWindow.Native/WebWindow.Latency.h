@@ -0,0 +1,45 @@
+#ifndef WEBWINDOW_LATENCY_H
+#define WEBWINDOW_LATENCY_H
+
+#include <cstdint>
+#include <cstdio>
+
+// Must match LatencyStage in WebWindow.cs
+enum LatencyStage
+{
+	LatencyStageBrowserEventToSend = 0,
+	LatencyStageNativeMessageDelivery = 1,
+	LatencyStageDispatchQueue = 2,
+	LatencyStageHandler = 3,
+	LatencyStageRenderAndSend = 4,
+	LatencyStageBrowserApply = 5,
+	LatencyStageTransit = 6,
+	LatencyStageEndToEnd = 7,
+	LatencyStageCount
+};
+
+// Must match NativeLatencyPercentiles in WebWindow.cs
+struct LatencyPercentiles
+{
+	int64_t count;
+	int64_t p50Micros;
+	int64_t p95Micros;
+	int64_t p99Micros;
+	int64_t maxMicros;
+};
+
+// Process-wide histograms of how long each stage of an interaction takes. Recording is
+// lock-free, so any thread can record at any time.
+class LatencyStatistics
+{
+public:
+	static void Enable(bool enabled);
+	static bool IsEnabled();
+	static int64_t NowMicros();
+	static void Record(int stage, int64_t micros);
+	static bool GetPercentiles(int stage, LatencyPercentiles* percentiles);
+	static void Dump(FILE* output);
+	static void Reset();
+};
+
+#endif // !WEBWINDOW_LATENCY_H
@@ -2,15 +2,26 @@
 //  sudo apt-get install libgtk-3-dev libwebkit2gtk-4.0-dev
 #ifdef OS_LINUX
 #include "WebWindow.h"
+#include "WebWindow.Latency.h"
 #include <mutex>
 #include <condition_variable>
 #include <X11/Xlib.h>
 #include <webkit2/webkit2.h>
 #include <JavaScriptCore/JavaScript.h>
-#include <sstream>
-#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fts.h>
+#include <malloc.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 std::mutex invokeLockMutex;
+bool rootWindowDestroyed = false;
 
 struct InvokeWaitInfo
 {
@@ -24,26 +35,68 @@ struct InvokeJSWaitInfo
 	bool isCompleted;
 };
 
+struct WebWindow::EvaluateScriptInfo
+{
+	WebWindow* window; // Null once the window has reported the evaluation as failed
+	EvaluateScriptCallback callback;
+	void* userData;
+};
+
+struct CaptureSnapshotInfo
+{
+	int x, y, width, height;
+	int targetWidth, targetHeight;
+	unsigned char* buffer;
+	int stride;
+	SnapshotCapturedCallback callback;
+	void* userData;
+};
+
 void on_size_allocate(GtkWidget* widget, GdkRectangle* allocation, gpointer self);
 gboolean on_configure_event(GtkWidget* widget, GdkEvent* event, gpointer self);
 
-WebWindow::WebWindow(AutoString title, WebWindow* parent, WebMessageReceivedCallback webMessageReceivedCallback) : _webview(nullptr)
+WebWindow::WebWindow(AutoString title, WebWindow* parent, WebMessageReceivedCallback webMessageReceivedCallback)
+	: _webview(nullptr), _isRootWindow(parent == NULL), _isHeadless(false), _headlessWidth(0), _headlessHeight(0),
+	_deliverMessagesOnBackgroundThread(false), _isMessageDeliveryStopping(false), _isMessageDeliveryFinished(false), _eventLoopFd(-1),
+	_memoryPressureFd(-1), _memoryPressureStopFd(-1), _pendingMemoryPressure(nullptr)
 {
 	_webMessageReceivedCallback = webMessageReceivedCallback;
+	_memoryPressureCallback = NULL;
 
 	// It makes xlib thread safe.
 	// Needed for get_position.
 	XInitThreads();
 
 	gtk_init(0, NULL);
+	_evaluationsCancellable = g_cancellable_new();
+
+	// Read here on the UI thread, so GetMemoryUsage can run on any thread
+	const gchar* diskCacheDirectory = webkit_website_data_manager_get_disk_cache_directory(
+		webkit_web_context_get_website_data_manager(webkit_web_context_get_default()));
+	_diskCacheDirectory = diskCacheDirectory ? diskCacheDirectory : "";
 	_window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
 	gtk_window_set_default_size(GTK_WINDOW(_window), 900, 600);
 	SetTitle(title);
+	ConnectWindowSignals();
+}
+
+void WebWindow::ConnectWindowSignals()
+{
+	// Closing the window destroys it, so forget it rather than destroying it again later
+	g_signal_connect(G_OBJECT(_window), "destroy", G_CALLBACK(gtk_widget_destroyed), &_window);
 
-	if (parent == NULL)
+	if (_isRootWindow)
 	{
 		g_signal_connect(G_OBJECT(_window), "destroy",
-			G_CALLBACK(+[](GtkWidget* w, gpointer arg) { gtk_main_quit(); }),
+			G_CALLBACK(+[](GtkWidget* w, gpointer arg) {
+				rootWindowDestroyed = true;
+
+				// There's no gtk_main to quit if the host is driving the loop through Pump
+				if (gtk_main_level() > 0)
+				{
+					gtk_main_quit();
+				}
+			}),
 			this);
 		g_signal_connect(G_OBJECT(_window), "size-allocate",
 			G_CALLBACK(on_size_allocate),
@@ -54,20 +107,186 @@ WebWindow::WebWindow(AutoString title, WebWindow* parent, WebMessageReceivedCall
 	}
 }
 
+// Must run on the UI thread, since it touches GTK. Use DestroyOnUiThread from anywhere else.
 WebWindow::~WebWindow()
 {
-	gtk_widget_destroy(_window);
+	StopBackgroundThreads();
+
+	// WebKit never completes evaluations once the web view is destroyed, so fail them here. If the
+	// cancellation does complete them later, the callback only frees the info.
+	g_cancellable_cancel(_evaluationsCancellable);
+	g_object_unref(_evaluationsCancellable);
+	for (EvaluateScriptInfo* info : _pendingEvaluations)
+	{
+		std::string_view message = "The window was destroyed before the script completed";
+		info->callback(info->userData, false, message.data(), message.size());
+		info->window = nullptr;
+	}
+	_pendingEvaluations.clear();
+
+	if (_eventLoopFd >= 0)
+	{
+		close(_eventLoopFd);
+	}
+
+	if (_window)
+	{
+		gtk_widget_destroy(_window);
+	}
+}
+
+// Must run on the UI thread. Safe to call more than once.
+void WebWindow::StopBackgroundThreads()
+{
+	if (_messageDeliveryThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> guard(_messageQueueMutex);
+			_isMessageDeliveryStopping = true;
+		}
+		_messageQueueNotifier.notify_one();
+
+		// The delivery thread may be in the middle of a handler that's waiting on Invoke, so keep
+		// the UI loop running until it has finished, rather than blocking it in join()
+		while (!_isMessageDeliveryFinished)
+		{
+			g_main_context_iteration(NULL, TRUE);
+		}
+		_messageDeliveryThread.join();
+
+		for (QueuedWebMessage& queued : _messageQueue)
+		{
+			g_free(queued.message);
+		}
+		_messageQueue.clear();
+	}
+
+	if (_memoryPressureThread.joinable())
+	{
+		uint64_t stop = 1;
+		write(_memoryPressureStopFd, &stop, sizeof(stop));
+		_memoryPressureThread.join();
+		close(_memoryPressureStopFd);
+		close(_memoryPressureFd);
+
+		// We're on the UI thread, so a pending notification can't be running right now
+		GSource* pending = _pendingMemoryPressure.exchange(nullptr);
+		if (pending)
+		{
+			g_source_destroy(pending);
+			g_source_unref(pending);
+		}
+	}
+}
+
+// The managed finalizer runs on its own thread, so it can't destroy the window directly
+void WebWindow::DestroyOnUiThread(WebWindow* instance)
+{
+	g_idle_add_full(G_PRIORITY_DEFAULT,
+		+[](gpointer data) -> gboolean {
+			delete (WebWindow*)data;
+			return FALSE;
+		},
+		instance,
+		NULL);
+}
+
+// Swaps the toplevel window for an offscreen one that renders at a fixed viewport size,
+// so everything (scheme handlers, messaging, Invoke and rendering) still runs but nothing
+// appears on screen. GTK still needs a display connection, which Xvfb can provide.
+// Only possible before the first call to Show, since that's when the webview is created.
+bool WebWindow::EnableHeadlessMode(int width, int height)
+{
+	if (_webview)
+	{
+		return false;
+	}
+
+	if (!_isHeadless)
+	{
+		// Disconnect our handlers first, so destroying the old window doesn't count as closing the app.
+		// The one that forgets the window is connected with &_window rather than this, so it's separate.
+		g_signal_handlers_disconnect_by_data(_window, this);
+		g_signal_handlers_disconnect_by_func(_window, (gpointer)gtk_widget_destroyed, &_window);
+		gchar* title = g_strdup(gtk_window_get_title(GTK_WINDOW(_window)));
+		gtk_widget_destroy(_window);
+
+		_window = gtk_offscreen_window_new();
+		_isHeadless = true;
+		gtk_window_set_title(GTK_WINDOW(_window), title);
+		g_free(title);
+		ConnectWindowSignals();
+	}
+
+	SetSize(width, height);
+	return true;
 }
 
-void HandleWebMessage(WebKitUserContentManager* contentManager, WebKitJavascriptResult* jsResult, gpointer arg)
+bool WebWindow::EnableBackgroundMessageDelivery()
+{
+	if (!_deliverMessagesOnBackgroundThread)
+	{
+		_deliverMessagesOnBackgroundThread = true;
+		_messageDeliveryThread = std::thread(&WebWindow::RunMessageDelivery, this);
+	}
+
+	return true;
+}
+
+// The GTK thread is the only producer and the delivery thread is the only consumer,
+// so messages reach the callback in exactly the order the page sent them
+void WebWindow::RunMessageDelivery()
+{
+	std::unique_lock<std::mutex> uLock(_messageQueueMutex);
+	while (true)
+	{
+		_messageQueueNotifier.wait(uLock, [&] { return _isMessageDeliveryStopping || !_messageQueue.empty(); });
+		if (_isMessageDeliveryStopping)
+		{
+			// Wake the UI thread, which runs its loop until it sees this
+			_isMessageDeliveryFinished = true;
+			g_main_context_wakeup(NULL);
+			return;
+		}
+
+		QueuedWebMessage queued = _messageQueue.front();
+		_messageQueue.pop_front();
+
+		// Don't hold the lock while running managed code, or the GTK thread could block on it
+		uLock.unlock();
+		if (queued.receivedMicros)
+		{
+			LatencyStatistics::Record(LatencyStageNativeMessageDelivery, LatencyStatistics::NowMicros() - queued.receivedMicros);
+		}
+		_webMessageReceivedCallback(queued.message);
+		g_free(queued.message);
+		uLock.lock();
+	}
+}
+
+// Takes ownership of the g_malloc'd message
+void WebWindow::ReceiveWebMessage(char* message)
+{
+	if (_deliverMessagesOnBackgroundThread)
+	{
+		{
+			std::lock_guard<std::mutex> guard(_messageQueueMutex);
+			_messageQueue.push_back({ message, LatencyStatistics::IsEnabled() ? LatencyStatistics::NowMicros() : 0 });
+		}
+		_messageQueueNotifier.notify_one();
+	}
+	else
+	{
+		_webMessageReceivedCallback(message);
+		g_free(message);
+	}
+}
+
+void HandleWebMessage(WebKitUserContentManager* contentManager, WebKitJavascriptResult* jsResult, gpointer self)
 {
 	JSCValue* jsValue = webkit_javascript_result_get_js_value(jsResult);
 	if (jsc_value_is_string(jsValue)) {
-		AutoString str_value = jsc_value_to_string(jsValue);
-
-		WebMessageReceivedCallback callback = (WebMessageReceivedCallback)arg;
-		callback(str_value);
-		g_free(str_value);
+		((WebWindow*)self)->ReceiveWebMessage(jsc_value_to_string(jsValue));
 	}
 
 	webkit_javascript_result_unref(jsResult);
@@ -98,14 +317,18 @@ void WebWindow::Show()
 		webkit_user_script_unref(script);
 
 		g_signal_connect(contentManager, "script-message-received::webwindowinterop",
-			G_CALLBACK(HandleWebMessage), (void*)_webMessageReceivedCallback);
+			G_CALLBACK(HandleWebMessage), this);
 		webkit_user_content_manager_register_script_message_handler(contentManager, "webwindowinterop");
 	}
 
 	gtk_widget_show_all(_window);
 
-	WebKitWebInspector* inspector = webkit_web_view_get_inspector(WEBKIT_WEB_VIEW(_webview));
-	webkit_web_inspector_show(WEBKIT_WEB_INSPECTOR(inspector));
+	// The inspector would open in a window of its own
+	if (!_isHeadless)
+	{
+		WebKitWebInspector* inspector = webkit_web_view_get_inspector(WEBKIT_WEB_VIEW(_webview));
+		webkit_web_inspector_show(WEBKIT_WEB_INSPECTOR(inspector));
+	}
 }
 
 void WebWindow::SetTitle(AutoString title)
@@ -113,11 +336,134 @@ void WebWindow::SetTitle(AutoString title)
 	gtk_window_set_title(GTK_WINDOW(_window), title);
 }
 
+void WebWindow::SetTitleUtf8(std::string_view title)
+{
+	// GTK needs it null-terminated, but titles are short
+	SetTitle((AutoString)std::string(title).c_str());
+}
+
 void WebWindow::WaitForExit()
 {
 	gtk_main();
 }
 
+// Returns an epoll fd that becomes readable whenever the GTK main context has work to do,
+// so a host with its own event loop can wait on it alongside everything else and call Pump
+// when it fires. It reflects the fds the context wanted as of the last call to Pump, so call
+// Pump once before first waiting on it.
+int WebWindow::GetEventLoopFd()
+{
+	if (_eventLoopFd < 0)
+	{
+		_eventLoopFd = epoll_create1(EPOLL_CLOEXEC);
+	}
+
+	return _eventLoopFd;
+}
+
+// Dispatches pending GTK work on the calling thread for up to maxMillis, without blocking
+// if there is none. The caller must then wait no longer than nextTimeoutMillis (-1 meaning
+// indefinitely) for the event loop fd before calling Pump again. Returns false once the
+// window has been closed.
+bool WebWindow::Pump(int maxMillis, int* nextTimeoutMillis)
+{
+	GMainContext* context = g_main_context_default();
+	if (!g_main_context_acquire(context))
+	{
+		// Some other thread (e.g., one in WaitForExit) owns the loop
+		*nextTimeoutMillis = -1;
+		return !rootWindowDestroyed;
+	}
+
+	gint64 deadline = g_get_monotonic_time() + (gint64)maxMillis * 1000;
+	while (IterateEventLoop(nextTimeoutMillis) && !rootWindowDestroyed)
+	{
+		if (g_get_monotonic_time() >= deadline)
+		{
+			// There may be more to do, so ask to be called straight back
+			*nextTimeoutMillis = 0;
+			break;
+		}
+	}
+
+	g_main_context_release(context);
+	return !rootWindowDestroyed;
+}
+
+// The same as g_main_context_iteration(context, FALSE), except that we keep hold of the
+// fds the context is interested in so the event loop fd can reflect them
+bool WebWindow::IterateEventLoop(int* nextTimeoutMillis)
+{
+	GMainContext* context = g_main_context_default();
+	gint maxPriority;
+	g_main_context_prepare(context, &maxPriority);
+
+	if (_pollFds.empty())
+	{
+		_pollFds.resize(16);
+	}
+
+	gint numPollFds;
+	while ((numPollFds = g_main_context_query(context, maxPriority, nextTimeoutMillis, _pollFds.data(), (gint)_pollFds.size())) > (gint)_pollFds.size())
+	{
+		_pollFds.resize(numPollFds);
+	}
+
+	// GPollFD has the same layout as struct pollfd on Linux
+	poll((struct pollfd*)_pollFds.data(), numPollFds, 0);
+
+	bool isReady = g_main_context_check(context, maxPriority, _pollFds.data(), numPollFds);
+	if (isReady)
+	{
+		g_main_context_dispatch(context);
+	}
+
+	if (_eventLoopFd >= 0)
+	{
+		UpdateEventLoopFd(numPollFds);
+	}
+
+	return isReady;
+}
+
+void WebWindow::UpdateEventLoopFd(int numPollFds)
+{
+	std::map<int, unsigned int> wanted;
+	for (int i = 0; i < numPollFds; i++)
+	{
+		// GIOCondition values match the poll() flags, which match the epoll ones
+		wanted[_pollFds[i].fd] |= _pollFds[i].events;
+	}
+
+	if (wanted == _eventLoopFdEvents)
+	{
+		return;
+	}
+
+	// Any change may mean GLib closed an fd and the number was reused, in which case epoll has
+	// already dropped the old registration. So re-register everything rather than just the differences.
+	for (auto& entry : _eventLoopFdEvents)
+	{
+		if (wanted.find(entry.first) == wanted.end())
+		{
+			epoll_ctl(_eventLoopFd, EPOLL_CTL_DEL, entry.first, NULL); // Fails harmlessly if it was already closed
+		}
+	}
+
+	for (auto& entry : wanted)
+	{
+		struct epoll_event event = {};
+		event.events = entry.second;
+		event.data.fd = entry.first;
+		if (epoll_ctl(_eventLoopFd, EPOLL_CTL_MOD, entry.first, &event) != 0 && errno == ENOENT)
+		{
+			epoll_ctl(_eventLoopFd, EPOLL_CTL_ADD, entry.first, &event);
+		}
+	}
+
+	_eventLoopFdEvents = std::move(wanted);
+}
+
 static gboolean invokeCallback(gpointer data)
 {
 	InvokeWaitInfo* waitInfo = (InvokeWaitInfo*)data;
@@ -144,6 +490,13 @@ void WebWindow::Invoke(ACTION callback)
 
 void WebWindow::ShowMessage(AutoString title, AutoString body, unsigned int type)
 {
+	if (_isHeadless)
+	{
+		// Nobody can dismiss a dialog, so don't block waiting for them to
+		fprintf(stderr, "%s: %s\n", title, body);
+		return;
+	}
+
 	GtkWidget* dialog = gtk_message_dialog_new(GTK_WINDOW(_window),
 		GTK_DIALOG_DESTROY_WITH_PARENT,
 		GTK_MESSAGE_OTHER,
@@ -165,29 +518,36 @@ void WebWindow::NavigateToString(AutoString content)
 	webkit_web_view_load_html(WEBKIT_WEB_VIEW(_webview), content, NULL);
 }
 
-// From https://stackoverflow.com/a/33799784
-std::string escape_json(const std::string& s) {
-	std::ostringstream o;
-	for (auto c = s.cbegin(); c != s.cend(); c++) {
-		switch (*c) {
-		case '"': o << "\\\""; break;
-		case '\\': o << "\\\\"; break;
-		case '\b': o << "\\b"; break;
-		case '\f': o << "\\f"; break;
-		case '\n': o << "\\n"; break;
-		case '\r': o << "\\r"; break;
-		case '\t': o << "\\t"; break;
+void WebWindow::NavigateToStringUtf8(std::string_view content)
+{
+	// Unlike load_html, this takes the length, so it doesn't need a terminator
+	GBytes* bytes = g_bytes_new(content.data(), content.size());
+	webkit_web_view_load_bytes(WEBKIT_WEB_VIEW(_webview), bytes, "text/html", "UTF-8", NULL);
+	g_bytes_unref(bytes);
+}
+
+// Based on https://stackoverflow.com/a/33799784
+void append_escaped_json(std::string& o, std::string_view s) {
+	for (char c : s) {
+		switch (c) {
+		case '"': o.append("\\\""); break;
+		case '\\': o.append("\\\\"); break;
+		case '\b': o.append("\\b"); break;
+		case '\f': o.append("\\f"); break;
+		case '\n': o.append("\\n"); break;
+		case '\r': o.append("\\r"); break;
+		case '\t': o.append("\\t"); break;
 		default:
-			if ('\x00' <= *c && *c <= '\x1f') {
-				o << "\\u"
-					<< std::hex << std::setw(4) << std::setfill('0') << (int)*c;
+			if ('\x00' <= c && c <= '\x1f') {
+				char escaped[7];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", (int)c);
+				o.append(escaped);
 			}
 			else {
-				o << *c;
+				o.push_back(c);
 			}
 		}
 	}
-	return o.str();
 }
 
 static void webview_eval_finished(GObject* object, GAsyncResult* result, gpointer userdata) {
@@ -197,10 +557,20 @@ static void webview_eval_finished(GObject* object, GAsyncResult* result, gpointe
 
 void WebWindow::SendMessage(AutoString message)
 {
+	SendMessageUtf8(message);
+}
+
+void WebWindow::SendMessageUtf8(std::string_view message)
+{
+	static const std::string_view prefix = "__dispatchMessageCallback(\"";
+	static const std::string_view suffix = "\")";
+
+	// Most messages need little or no escaping, so this usually avoids any reallocation
 	std::string js;
-	js.append("__dispatchMessageCallback(\"");
-	js.append(escape_json(message));
-	js.append("\")");
+	js.reserve(prefix.size() + message.size() + message.size() / 8 + suffix.size());
+	js.append(prefix);
+	append_escaped_json(js, message);
+	js.append(suffix);
 
 	InvokeJSWaitInfo invokeJsWaitInfo = {};
 	webkit_web_view_run_javascript(WEBKIT_WEB_VIEW(_webview),
@@ -210,6 +580,433 @@ void WebWindow::SendMessage(AutoString message)
 	}
 }
 
+// Must be called on the UI thread. Returns immediately, so any number of evaluations can be
+// in flight at once. The callback runs on the UI thread with the result serialized as JSON.
+// Evaluations still in flight when the window is destroyed are reported as failed.
+void WebWindow::EvaluateScript(std::string_view script, EvaluateScriptCallback callback, void* userData)
+{
+	EvaluateScriptInfo* info = new EvaluateScriptInfo{ this, callback, userData };
+	_pendingEvaluations.insert(info);
+	webkit_web_view_run_javascript(WEBKIT_WEB_VIEW(_webview),
+		std::string(script).c_str(), _evaluationsCancellable,
+		+[](GObject* object, GAsyncResult* result, gpointer userdata) {
+			EvaluateScriptInfo* info = (EvaluateScriptInfo*)userdata;
+			GError* error = NULL;
+			WebKitJavascriptResult* jsResult = webkit_web_view_run_javascript_finish(WEBKIT_WEB_VIEW(object), result, &error);
+			if (info->window)
+			{
+				info->window->_pendingEvaluations.erase(info);
+				if (jsResult)
+				{
+					// Returns NULL for undefined, which has no JSON representation
+					char* json = jsc_value_to_json(webkit_javascript_result_get_js_value(jsResult), 0);
+					std::string_view resultJson = json ? std::string_view(json) : std::string_view("null");
+					info->callback(info->userData, true, resultJson.data(), resultJson.size());
+					g_free(json);
+				}
+				else
+				{
+					std::string_view message = error->message;
+					info->callback(info->userData, false, message.data(), message.size());
+				}
+			}
+
+			if (jsResult)
+			{
+				webkit_javascript_result_unref(jsResult);
+			}
+			else
+			{
+				g_error_free(error);
+			}
+
+			delete info;
+		},
+		info);
+}
+
+static void snapshot_finished(GObject* object, GAsyncResult* result, gpointer userdata)
+{
+	CaptureSnapshotInfo* info = (CaptureSnapshotInfo*)userdata;
+	cairo_surface_t* snapshot = webkit_web_view_get_snapshot_finish(WEBKIT_WEB_VIEW(object), result, NULL);
+	if (snapshot)
+	{
+		// Wrap the caller's buffer in a surface so cairo crops and scales straight into it. ARGB32
+		// is native-endian, so on little-endian machines the bytes are in BGRA order.
+		cairo_surface_t* target = cairo_image_surface_create_for_data(info->buffer, CAIRO_FORMAT_ARGB32,
+			info->targetWidth, info->targetHeight, info->stride);
+		cairo_t* cr = cairo_create(target);
+		cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+		cairo_scale(cr, (double)info->targetWidth / info->width, (double)info->targetHeight / info->height);
+		cairo_set_source_surface(cr, snapshot, -info->x, -info->y);
+		cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
+		cairo_paint(cr);
+		cairo_destroy(cr);
+		cairo_surface_flush(target);
+		cairo_surface_destroy(target);
+		cairo_surface_destroy(snapshot);
+	}
+
+	info->callback(info->userData, snapshot != NULL);
+	delete info;
+}
+
+// Must be called on the UI thread. Captures the region (in CSS pixels, relative to the visible
+// viewport) scaled to targetWidth x targetHeight into the caller's buffer, which must stay valid
+// until the callback runs on the UI thread. Returns false, without calling the callback, if the
+// capture couldn't be started.
+bool WebWindow::CaptureSnapshot(int x, int y, int width, int height, int targetWidth, int targetHeight,
+	unsigned char* buffer, int stride, SnapshotCapturedCallback callback, void* userData)
+{
+	if (!_webview || width <= 0 || height <= 0 || targetWidth <= 0 || targetHeight <= 0
+		|| stride < targetWidth * 4 || stride % 4 != 0)
+	{
+		return false;
+	}
+
+	CaptureSnapshotInfo* info = new CaptureSnapshotInfo{ x, y, width, height, targetWidth, targetHeight, buffer, stride, callback, userData };
+	webkit_web_view_get_snapshot(WEBKIT_WEB_VIEW(_webview), WEBKIT_SNAPSHOT_REGION_VISIBLE, WEBKIT_SNAPSHOT_OPTIONS_NONE,
+		NULL, snapshot_finished, info);
+	return true;
+}
+
+static int64_t ReadResidentBytes(const char* statmPath)
+{
+	FILE* file = fopen(statmPath, "r");
+	if (!file)
+	{
+		return -1;
+	}
+
+	long long totalPages, residentPages;
+	int matched = fscanf(file, "%lld %lld", &totalPages, &residentPages);
+	fclose(file);
+	return matched == 2 ? residentPages * sysconf(_SC_PAGESIZE) : -1;
+}
+
+struct WebKitChildProcess
+{
+	int pid;
+	std::string name;
+};
+
+// WebKit doesn't expose its helper processes, so look for children of ours with WebKit names
+// (WebKitWebProcess, WebKitNetworkProcess and so on, truncated to 15 characters by the kernel).
+// WebKit doesn't say which web process serves which webview either, so they're reported
+// for the app as a whole.
+static std::vector<WebKitChildProcess> FindWebKitChildProcesses()
+{
+	std::vector<WebKitChildProcess> result;
+	DIR* proc = opendir("/proc");
+	if (!proc)
+	{
+		return result;
+	}
+
+	int self = getpid();
+	while (dirent* entry = readdir(proc))
+	{
+		int pid = atoi(entry->d_name);
+		if (pid <= 0)
+		{
+			continue;
+		}
+
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+		FILE* file = fopen(path, "r");
+		if (!file)
+		{
+			continue;
+		}
+
+		char stat[512];
+		size_t length = fread(stat, 1, sizeof(stat) - 1, file);
+		fclose(file);
+		stat[length] = '\0';
+
+		// The format is "pid (name) state ppid ...", and the name can itself contain spaces and parentheses
+		char* nameStart = strchr(stat, '(');
+		char* nameEnd = strrchr(stat, ')');
+		char state;
+		int ppid;
+		if (!nameStart || !nameEnd || sscanf(nameEnd + 1, " %c %d", &state, &ppid) != 2 || ppid != self)
+		{
+			continue;
+		}
+
+		std::string name(nameStart + 1, nameEnd - nameStart - 1);
+		if (name.compare(0, 6, "WebKit") == 0)
+		{
+			result.push_back({ pid, name });
+		}
+	}
+
+	closedir(proc);
+	return result;
+}
+
+static int64_t GetDirectorySize(const std::string& path)
+{
+	char* paths[] = { (char*)path.c_str(), NULL };
+	FTS* fts = fts_open(paths, FTS_PHYSICAL | FTS_NOCHDIR, NULL);
+	if (!fts)
+	{
+		return -1;
+	}
+
+	int64_t totalBytes = 0;
+	FTSENT* entry;
+	while ((entry = fts_read(fts)) != NULL)
+	{
+		if (entry->fts_info == FTS_F)
+		{
+			totalBytes += entry->fts_statp->st_size;
+		}
+	}
+
+	fts_close(fts);
+	return totalBytes;
+}
+
+// Doesn't touch GTK, so it can be called from any thread. That's worth doing, since walking the
+// disk cache can take a while.
+bool WebWindow::GetMemoryUsage(MemoryUsage* usage)
+{
+	usage->processResidentBytes = ReadResidentBytes("/proc/self/statm");
+	usage->webProcessResidentBytes = 0;
+	usage->webProcessCount = 0;
+	for (WebKitChildProcess& process : FindWebKitChildProcesses())
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/%d/statm", process.pid);
+		int64_t residentBytes = ReadResidentBytes(path);
+		if (residentBytes >= 0)
+		{
+			usage->webProcessResidentBytes += residentBytes;
+			usage->webProcessCount++;
+		}
+	}
+
+	usage->diskCacheBytes = _diskCacheDirectory.empty() ? 0 : GetDirectorySize(_diskCacheDirectory);
+	return true;
+}
+
+void WebWindow::GetWebProcesses(GetWebProcessesCallback callback)
+{
+	for (WebKitChildProcess& process : FindWebKitChildProcesses())
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/%d/statm", process.pid);
+		int64_t residentBytes = ReadResidentBytes(path);
+		if (residentBytes >= 0 && !callback(process.pid, process.name.c_str(), residentBytes))
+		{
+			break;
+		}
+	}
+}
+
+// The cache model as it was before the first critical trim, to be put back once pressure subsides.
+// The cache model belongs to the default web context, so this is process-wide rather than per
+// window. Only accessed on the UI thread.
+static WebKitCacheModel cacheModelBeforeTrim;
+static guint restoreCacheModelSourceId = 0;
+
+// The memory pressure monitor trims at the critical level at least every 30s for as long as
+// pressure lasts, so this long without another critical trim means it has subsided
+const guint restoreCacheModelDelaySeconds = 60;
+
+// The caches are shared by every webview in the process, so this trims them for all windows
+void WebWindow::TrimMemory(int level)
+{
+	WebKitWebContext* context = webkit_web_context_get_default();
+	if (level >= MemoryTrimLevelModerate)
+	{
+		// Clears both the memory and disk caches
+		webkit_web_context_clear_cache(context);
+	}
+	else
+	{
+		webkit_website_data_manager_clear(webkit_web_context_get_website_data_manager(context),
+			WEBKIT_WEBSITE_DATA_MEMORY_CACHE, 0, NULL, NULL, NULL);
+	}
+
+	if (level >= MemoryTrimLevelCritical)
+	{
+		// Keep WebKit from building the caches back up until the pressure is over
+		if (restoreCacheModelSourceId)
+		{
+			g_source_remove(restoreCacheModelSourceId);
+		}
+		else
+		{
+			cacheModelBeforeTrim = webkit_web_context_get_cache_model(context);
+			webkit_web_context_set_cache_model(context, WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER);
+		}
+
+		restoreCacheModelSourceId = g_timeout_add_seconds(restoreCacheModelDelaySeconds,
+			+[](gpointer data) -> gboolean {
+				webkit_web_context_set_cache_model(webkit_web_context_get_default(), cacheModelBeforeTrim);
+				restoreCacheModelSourceId = 0;
+				return FALSE;
+			},
+			NULL);
+	}
+
+	// Hand freed native heap pages back to the OS
+	malloc_trim(0);
+}
+
+// Makes web processes start releasing memory themselves once they pass the limit, and kill
+// themselves if they get well beyond it. This applies to every web process in the app, not just
+// this window's. Only has an effect before the first web process starts, i.e., before the first
+// call to Show, and needs WebKitGTK 2.34 or later.
+bool WebWindow::SetWebProcessMemoryLimit(int megabytes)
+{
+#if WEBKIT_CHECK_VERSION(2, 34, 0)
+	WebKitMemoryPressureSettings* settings = webkit_memory_pressure_settings_new();
+	webkit_memory_pressure_settings_set_memory_limit(settings, megabytes);
+	webkit_website_data_manager_set_memory_pressure_settings(settings);
+	webkit_memory_pressure_settings_free(settings);
+	return !_webview;
+#else
+	return false;
+#endif
+}
+
+// Prefer our own cgroup's pressure file, since a container or systemd unit with a memory limit
+// can be under pressure when the machine as a whole isn't. Returns -1 if PSI isn't available.
+static int OpenMemoryPressureTrigger()
+{
+	std::vector<std::string> candidates;
+	FILE* cgroups = fopen("/proc/self/cgroup", "r");
+	if (cgroups)
+	{
+		char line[1024];
+		while (fgets(line, sizeof(line), cgroups))
+		{
+			// The cgroup v2 hierarchy is the one listed as "0::/path"
+			if (strncmp(line, "0::", 3) == 0)
+			{
+				line[strcspn(line, "\n")] = '\0';
+				candidates.push_back(std::string("/sys/fs/cgroup") + (line + 3) + "/memory.pressure");
+			}
+		}
+		fclose(cgroups);
+	}
+	candidates.push_back("/proc/pressure/memory");
+
+	// Fires when some task has been stalled on memory for 150ms in a 2s window. Unprivileged
+	// processes are only allowed windows that are a multiple of 2s.
+	const char trigger[] = "some 150000 2000000";
+	for (std::string& path : candidates)
+	{
+		int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+		if (fd >= 0)
+		{
+			if (write(fd, trigger, sizeof(trigger)) >= 0)
+			{
+				return fd;
+			}
+			close(fd);
+		}
+	}
+
+	return -1;
+}
+
+// Watches for Linux pressure stall information (PSI) events, and passes them to the callback on
+// the UI thread as a trim level. Returns false if the kernel doesn't support PSI triggers.
+bool WebWindow::EnableMemoryPressureMonitoring(MemoryPressureCallback callback)
+{
+	_memoryPressureCallback = callback;
+	if (_memoryPressureThread.joinable())
+	{
+		return true;
+	}
+
+	_memoryPressureFd = OpenMemoryPressureTrigger();
+	if (_memoryPressureFd < 0)
+	{
+		return false;
+	}
+
+	_memoryPressureStopFd = eventfd(0, EFD_CLOEXEC);
+	_memoryPressureThread = std::thread(&WebWindow::RunMemoryPressureMonitor, this);
+	return true;
+}
+
+struct MemoryPressureInfo
+{
+	WebWindow* window;
+	int level;
+};
+
+void WebWindow::RunMemoryPressureMonitor()
+{
+	// The trigger fires once per window for as long as the pressure lasts. Trimming takes a
+	// while to have an effect, so don't do it more often than this, and if we're still under
+	// pressure soon after that, trim harder.
+	const gint64 minTrimIntervalMicros = 10 * G_USEC_PER_SEC;
+	const gint64 escalationIntervalMicros = 30 * G_USEC_PER_SEC;
+	gint64 lastTrimTime = 0;
+
+	struct pollfd fds[2] = { { _memoryPressureFd, POLLPRI, 0 }, { _memoryPressureStopFd, POLLIN, 0 } };
+	while (true)
+	{
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return;
+		}
+
+		if (fds[1].revents || (fds[0].revents & POLLERR))
+		{
+			// Stopping, or the trigger went away (e.g., because the cgroup was removed)
+			return;
+		}
+
+		gint64 now = g_get_monotonic_time();
+		if (!(fds[0].revents & POLLPRI) || (lastTrimTime && now - lastTrimTime < minTrimIntervalMicros))
+		{
+			continue;
+		}
+
+		int level = lastTrimTime && now - lastTrimTime < escalationIntervalMicros ? MemoryTrimLevelCritical : MemoryTrimLevelModerate;
+		lastTrimTime = now;
+
+		// Publish the source before attaching it, since it can be dispatched (and clear the field)
+		// as soon as it's attached. The interval means there's normally never more than one pending,
+		// but if the UI thread is that far behind, the new level replaces the old one.
+		GSource* source = g_idle_source_new();
+		g_source_set_priority(source, G_PRIORITY_DEFAULT_IDLE);
+		g_source_set_callback(source,
+			+[](gpointer data) -> gboolean {
+				MemoryPressureInfo* info = (MemoryPressureInfo*)data;
+				GSource* current = g_main_current_source();
+				if (info->window->_pendingMemoryPressure.compare_exchange_strong(current, nullptr))
+				{
+					g_source_unref(current);
+				}
+				info->window->InvokeMemoryPressure(info->level);
+				return FALSE;
+			},
+			new MemoryPressureInfo{ this, level },
+			+[](gpointer data) { delete (MemoryPressureInfo*)data; });
+
+		GSource* previous = _pendingMemoryPressure.exchange(source);
+		if (previous)
+		{
+			g_source_destroy(previous);
+			g_source_unref(previous);
+		}
+		g_source_attach(source, NULL);
+	}
+}
+
 void HandleCustomSchemeRequest(WebKitURISchemeRequest* request, gpointer user_data)
 {
 	WebResourceRequestedCallback webResourceRequestedCallback = (WebResourceRequestedCallback)user_data;
@@ -218,7 +1015,8 @@ void HandleCustomSchemeRequest(WebKitURISchemeRequest* request, gpointer user_da
 	int numBytes;
 	AutoString contentType;
 	void* dotNetResponse = webResourceRequestedCallback((AutoString)uri, &numBytes, &contentType);
-	GInputStream* stream = g_memory_input_stream_new_from_data(dotNetResponse, numBytes, NULL);
+	// The stream takes ownership of the response, which .NET allocated with malloc
+	GInputStream* stream = g_memory_input_stream_new_from_data(dotNetResponse, numBytes, free);
 	webkit_uri_scheme_request_finish(request, (GInputStream*)stream, -1, contentType);
 	g_object_unref(stream);
 	delete[] contentType;
@@ -239,18 +1037,36 @@ void WebWindow::SetResizable(bool resizable)
 
 void WebWindow::GetSize(int* width, int* height)
 {
-	gtk_window_get_size(GTK_WINDOW(_window), width, height);
+	if (_isHeadless)
+	{
+		*width = _headlessWidth;
+		*height = _headlessHeight;
+	}
+	else
+	{
+		gtk_window_get_size(GTK_WINDOW(_window), width, height);
+	}
 }
 
 void WebWindow::SetSize(int width, int height)
 {
-	gtk_window_resize(GTK_WINDOW(_window), width, height);
+	if (_isHeadless)
+	{
+		// Offscreen windows take their size from their size request
+		_headlessWidth = width;
+		_headlessHeight = height;
+		gtk_widget_set_size_request(_window, width, height);
+	}
+	else
+	{
+		gtk_window_resize(GTK_WINDOW(_window), width, height);
+	}
 }
 
 void on_size_allocate(GtkWidget* widget, GdkRectangle* allocation, gpointer self)
 {
 	int width, height;
-	gtk_window_get_size(GTK_WINDOW(widget), &width, &height);
+	((WebWindow*)self)->GetSize(&width, &height);
 	((WebWindow*)self)->InvokeResized(width, height);
 }
 
@@ -37,6 +37,7 @@ void WebWindow::Register()
 WebWindow::WebWindow(AutoString title, WebWindow* parent, WebMessageReceivedCallback webMessageReceivedCallback)
 {
     _webMessageReceivedCallback = webMessageReceivedCallback;
+    _memoryPressureCallback = NULL;
     NSRect frame = NSMakeRect(0, 0, 900, 600);
     NSWindow *window = [[NSWindow alloc]
         initWithContentRect:frame
@@ -48,6 +49,16 @@ WebWindow::WebWindow(AutoString title, WebWindow* parent, WebMessageReceivedCall
     [window cascadeTopLeftFromPoint:NSMakePoint(20,20)];
     SetTitle(title);
 
+    // Pump reports this on every later call
+    _isClosed = false;
+    _windowCloseObserver = [[NSNotificationCenter defaultCenter]
+        addObserverForName:NSWindowWillCloseNotification
+        object:window
+        queue:nil
+        usingBlock:^(NSNotification* notification) {
+            _isClosed = true;
+        }];
+
     WKWebViewConfiguration *webViewConfiguration = [[WKWebViewConfiguration alloc] init];
     [webViewConfiguration.preferences setValue:@YES forKey:@"developerExtrasEnabled"];
     _webviewConfiguration = webViewConfiguration;
@@ -56,6 +67,7 @@ WebWindow::WebWindow(AutoString title, WebWindow* parent, WebMessageReceivedCall
 
 WebWindow::~WebWindow()
 {
+    [[NSNotificationCenter defaultCenter] removeObserver:(id)_windowCloseObserver];
     WKWebViewConfiguration *webViewConfiguration = (WKWebViewConfiguration*)_webviewConfiguration;
     [webViewConfiguration release];
     WKWebView *webView = (WKWebView*)_webview;
@@ -64,6 +76,19 @@ WebWindow::~WebWindow()
     [window close];
 }
 
+// The managed finalizer runs on its own thread, and AppKit must only be used on the main thread
+void WebWindow::DestroyOnUiThread(WebWindow* instance)
+{
+    dispatch_async(dispatch_get_main_queue(), ^(void){
+        delete instance;
+    });
+}
+
+void WebWindow::StopBackgroundThreads()
+{
+    // Not implemented on Mac yet
+}
+
 void WebWindow::AttachWebView()
 {
     MyUiDelegate *uiDelegate = [[[MyUiDelegate alloc] init] autorelease];
@@ -123,11 +148,68 @@ void WebWindow::SetTitle(AutoString title)
     [window setTitle:nstitle];
 }
 
+NSString* Utf8ToNSString(std::string_view utf8)
+{
+    return [[[NSString alloc] initWithBytes:utf8.data() length:utf8.size() encoding:NSUTF8StringEncoding] autorelease];
+}
+
+void WebWindow::SetTitleUtf8(std::string_view title)
+{
+    NSWindow* window = (NSWindow*)_window;
+    [window setTitle:Utf8ToNSString(title)];
+}
+
 void WebWindow::WaitForExit()
 {
     [NSApp run];
 }
 
+// The Cocoa run loop has no file descriptor to wait on, so Pump asks the host to poll again this
+// often, to pick up work from Invoke and WKWebView callbacks
+static const int pumpPollIntervalMillis = 10;
+
+bool WebWindow::Pump(int maxMillis, int* nextTimeoutMillis)
+{
+    static bool hasFinishedLaunching = false;
+    if (!hasFinishedLaunching)
+    {
+        // [NSApp run] would normally do this
+        [NSApp finishLaunching];
+        hasFinishedLaunching = true;
+    }
+
+    NSDate* deadline = [NSDate dateWithTimeIntervalSinceNow:maxMillis / 1000.0];
+    while (true)
+    {
+        NSEvent* event = [NSApp nextEventMatchingMask:NSEventMaskAny untilDate:[NSDate distantPast] inMode:NSDefaultRunLoopMode dequeue:YES];
+        if (event == nil)
+        {
+            break;
+        }
+
+        [NSApp sendEvent:event];
+        if (_isClosed)
+        {
+            break;
+        }
+
+        if ([deadline timeIntervalSinceNow] <= 0)
+        {
+            *nextTimeoutMillis = 0;
+            return true;
+        }
+    }
+
+    *nextTimeoutMillis = pumpPollIntervalMillis;
+    return !_isClosed;
+}
+
+int WebWindow::GetEventLoopFd()
+{
+    // The Cocoa run loop can't be waited on through a file descriptor
+    return -1;
+}
+
 void WebWindow::Invoke(ACTION callback)
 {
     dispatch_sync(dispatch_get_main_queue(), ^(void){
@@ -166,6 +248,12 @@ void WebWindow::NavigateToString(AutoString content)
     [webView loadHTMLString:nscontent baseURL:nil];
 }
 
+void WebWindow::NavigateToStringUtf8(std::string_view content)
+{
+    WKWebView *webView = (WKWebView *)_webview;
+    [webView loadHTMLString:Utf8ToNSString(content) baseURL:nil];
+}
+
 void WebWindow::NavigateToUrl(AutoString url)
 {
     WKWebView *webView = (WKWebView *)_webview;
@@ -176,9 +264,14 @@ void WebWindow::NavigateToUrl(AutoString url)
 }
 
 void WebWindow::SendMessage(AutoString message)
+{
+    SendMessageUtf8(message);
+}
+
+void WebWindow::SendMessageUtf8(std::string_view message)
 {
     // JSON-encode the message
-    NSString* nsmessage = [NSString stringWithUTF8String:message];
+    NSString* nsmessage = Utf8ToNSString(message);
     NSData* data = [NSJSONSerialization dataWithJSONObject:@[nsmessage] options:0 error:nil];
     NSString *nsmessageJson = [[[NSString alloc]
         initWithData:data
@@ -190,6 +283,75 @@ void WebWindow::SendMessage(AutoString message)
     [webView evaluateJavaScript:javaScriptToEval completionHandler:nil];
 }
 
+void WebWindow::EvaluateScript(std::string_view script, EvaluateScriptCallback callback, void* userData)
+{
+    WKWebView *webView = (WKWebView *)_webview;
+    [webView evaluateJavaScript:Utf8ToNSString(script) completionHandler:^(id result, NSError *error) {
+        // Wrap in an array, since older versions of NSJSONSerialization won't serialize
+        // top-level scalars, then strip the brackets off again
+        NSData* data = nil;
+        if (error == nil)
+        {
+            NSArray* wrapped = @[result ?: [NSNull null]];
+            if ([NSJSONSerialization isValidJSONObject:wrapped])
+            {
+                data = [NSJSONSerialization dataWithJSONObject:wrapped options:0 error:&error];
+            }
+            else
+            {
+                // Results such as dates or other native objects have no JSON form. Checking first
+                // matters, since dataWithJSONObject throws for them rather than returning an error.
+                NSString* message = [NSString stringWithFormat:@"The script result of type %@ can't be represented as JSON", NSStringFromClass([result class])];
+                error = [NSError errorWithDomain:@"WebWindow" code:0 userInfo:@{ NSLocalizedDescriptionKey: message }];
+            }
+        }
+
+        if (data != nil && data.length >= 2)
+        {
+            const char* json = (const char*)data.bytes;
+            callback(userData, true, json + 1, data.length - 2);
+        }
+        else
+        {
+            const char* message = error ? [[error localizedDescription] UTF8String] : "The script result couldn't be serialized";
+            callback(userData, false, message, strlen(message));
+        }
+    }];
+}
+
+bool WebWindow::CaptureSnapshot(int x, int y, int width, int height, int targetWidth, int targetHeight,
+    unsigned char* buffer, int stride, SnapshotCapturedCallback callback, void* userData)
+{
+    if (width <= 0 || height <= 0 || targetWidth <= 0 || targetHeight <= 0 || stride < targetWidth * 4)
+    {
+        return false;
+    }
+
+    WKWebView *webView = (WKWebView *)_webview;
+    WKSnapshotConfiguration* configuration = [[[WKSnapshotConfiguration alloc] init] autorelease];
+    configuration.rect = NSMakeRect(x, y, width, height);
+    configuration.snapshotWidth = @(targetWidth);
+    [webView takeSnapshotWithConfiguration:configuration completionHandler:^(NSImage *image, NSError *error) {
+        CGImageRef cgImage = image ? [image CGImageForProposedRect:NULL context:nil hints:nil] : NULL;
+        if (cgImage == NULL)
+        {
+            callback(userData, false);
+            return;
+        }
+
+        // Draw straight into the caller's buffer, in BGRA order
+        CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+        CGContextRef context = CGBitmapContextCreate(buffer, targetWidth, targetHeight, 8, stride, colorSpace,
+            kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little);
+        CGContextSetBlendMode(context, kCGBlendModeCopy);
+        CGContextDrawImage(context, CGRectMake(0, 0, targetWidth, targetHeight), cgImage);
+        CGContextRelease(context);
+        CGColorSpaceRelease(colorSpace);
+        callback(userData, true);
+    }];
+    return true;
+}
+
 void WebWindow::AddCustomScheme(AutoString scheme, WebResourceRequestedCallback requestHandler)
 {
     // Note that this can only be done *before* the WKWebView is instantiated, so we only let this
@@ -281,6 +443,54 @@ void WebWindow::SetTopmost(bool topmost)
     else [window setLevel:NSNormalWindowLevel];
 }
 
+bool WebWindow::EnableBackgroundMessageDelivery()
+{
+    // Not implemented on Mac yet. Messages are delivered on the main thread.
+    return false;
+}
+
+bool WebWindow::EnableHeadlessMode(int width, int height)
+{
+    // Not implemented on Mac yet
+    return false;
+}
+
+bool WebWindow::GetMemoryUsage(MemoryUsage* usage)
+{
+    // Not implemented on Mac yet
+    return false;
+}
+
+void WebWindow::GetWebProcesses(GetWebProcessesCallback callback)
+{
+    // Not implemented on Mac yet
+}
+
+void WebWindow::TrimMemory(int level)
+{
+    NSMutableSet* dataTypes = [NSMutableSet setWithObject:WKWebsiteDataTypeMemoryCache];
+    if (level >= MemoryTrimLevelModerate)
+    {
+        [dataTypes addObject:WKWebsiteDataTypeDiskCache];
+    }
+
+    [[WKWebsiteDataStore defaultDataStore] removeDataOfTypes:dataTypes
+        modifiedSince:[NSDate distantPast]
+        completionHandler:^{}];
+}
+
+bool WebWindow::SetWebProcessMemoryLimit(int megabytes)
+{
+    // Not implemented on Mac yet
+    return false;
+}
+
+bool WebWindow::EnableMemoryPressureMonitoring(MemoryPressureCallback callback)
+{
+    // Not implemented on Mac yet
+    return false;
+}
+
 void WebWindow::SetIconFile(AutoString filename)
 {
 	NSString* path = [[NSString stringWithUTF8String:filename] autorelease];
@@ -17,6 +17,11 @@ LPCWSTR CLASS_NAME = L"WebWindow";
 std::mutex invokeLockMutex;
 HINSTANCE WebWindow::_hInstance;
 HWND messageLoopRootWindowHandle;
+bool messageLoopRootWindowClosed = false;
+
+// There's no file descriptor to wait on here, and Invoke from other threads and WebView2 callbacks
+// arrive as window messages, so Pump asks the host to poll again this often
+const int pumpPollIntervalMillis = 10;
 std::map<HWND, WebWindow*> hwndToWebWindow;
 
 struct InvokeWaitInfo
@@ -50,6 +55,7 @@ WebWindow::WebWindow(AutoString title, WebWindow* parent, WebMessageReceivedCall
 {
 	// Create the window
 	_webMessageReceivedCallback = webMessageReceivedCallback;
+	_memoryPressureCallback = NULL;
 	_parent = parent;
 	_hWnd = CreateWindowEx(
 		0,                              // Optional window styles.
@@ -71,6 +77,17 @@ WebWindow::WebWindow(AutoString title, WebWindow* parent, WebMessageReceivedCall
 // Needn't to release the handles.
 WebWindow::~WebWindow() {}
 
+void WebWindow::DestroyOnUiThread(WebWindow* instance)
+{
+	// The destructor doesn't touch the window, so there's no need to marshal it
+	delete instance;
+}
+
+void WebWindow::StopBackgroundThreads()
+{
+	// Not implemented on Windows yet
+}
+
 HWND WebWindow::getHwnd()
 {
 	return _hWnd;
@@ -87,6 +104,8 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 		hwndToWebWindow.erase(hwnd);
 		if (hwnd == messageLoopRootWindowHandle)
 		{
+			// Pump reports this on every later call, even if something else takes the WM_QUIT
+			messageLoopRootWindowClosed = true;
 			PostQuitMessage(0);
 		}
 		return 0;
@@ -155,6 +174,19 @@ void WebWindow::SetTitle(AutoString title)
 	SetWindowText(_hWnd, title);
 }
 
+std::wstring Utf8ToWide(std::string_view utf8)
+{
+	int numChars = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), (int)utf8.size(), NULL, 0);
+	std::wstring result(numChars, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, utf8.data(), (int)utf8.size(), &result[0], numChars);
+	return result;
+}
+
+void WebWindow::SetTitleUtf8(std::string_view title)
+{
+	SetTitle(Utf8ToWide(title).c_str());
+}
+
 void WebWindow::Show()
 {
 	ShowWindow(_hWnd, SW_SHOWDEFAULT);
@@ -181,6 +213,43 @@ void WebWindow::WaitForExit()
 	}
 }
 
+bool WebWindow::Pump(int maxMillis, int* nextTimeoutMillis)
+{
+	// The first window to be pumped is the root, as with WaitForExit
+	if (!messageLoopRootWindowHandle)
+	{
+		messageLoopRootWindowHandle = _hWnd;
+	}
+
+	DWORD deadline = GetTickCount() + maxMillis;
+	MSG msg = { };
+	while (!messageLoopRootWindowClosed && PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+	{
+		if (msg.message == WM_QUIT)
+		{
+			break;
+		}
+
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+
+		if ((int)(GetTickCount() - deadline) >= 0)
+		{
+			*nextTimeoutMillis = 0;
+			return !messageLoopRootWindowClosed;
+		}
+	}
+
+	*nextTimeoutMillis = pumpPollIntervalMillis;
+	return !messageLoopRootWindowClosed;
+}
+
+int WebWindow::GetEventLoopFd()
+{
+	// The Win32 message queue can't be waited on through a file descriptor
+	return -1;
+}
+
 void WebWindow::ShowMessage(AutoString title, AutoString body, UINT type)
 {
 	ShowMessageParams* params = new ShowMessageParams;
@@ -318,11 +387,57 @@ void WebWindow::NavigateToString(AutoString content)
 	_webviewWindow->NavigateToString(content);
 }
 
+void WebWindow::NavigateToStringUtf8(std::string_view content)
+{
+	// WebView2 only takes UTF-16, so this path can't avoid a conversion on Windows
+	NavigateToString(Utf8ToWide(content).c_str());
+}
+
 void WebWindow::SendMessage(AutoString message)
 {
 	_webviewWindow->PostWebMessageAsString(message);
 }
 
+void WebWindow::SendMessageUtf8(std::string_view message)
+{
+	SendMessage(Utf8ToWide(message).c_str());
+}
+
+std::string WideToUtf8(const wchar_t* wide)
+{
+	int numBytes = WideCharToMultiByte(CP_UTF8, 0, wide, -1, NULL, 0, NULL, NULL);
+	std::string result(numBytes, '\0');
+	WideCharToMultiByte(CP_UTF8, 0, wide, -1, &result[0], numBytes, NULL, NULL);
+	result.resize(numBytes > 0 ? numBytes - 1 : 0); // Drop the terminator
+	return result;
+}
+
+void WebWindow::EvaluateScript(std::string_view script, EvaluateScriptCallback callback, void* userData)
+{
+	_webviewWindow->ExecuteScript(Utf8ToWide(script).c_str(), Callback<IWebView2ExecuteScriptCompletedHandler>(
+		[callback, userData](HRESULT errorCode, LPCWSTR resultObjectAsJson) -> HRESULT {
+			if (errorCode == S_OK)
+			{
+				std::string result = WideToUtf8(resultObjectAsJson);
+				callback(userData, true, result.data(), result.size());
+			}
+			else
+			{
+				_com_error err(errorCode);
+				std::string message = WideToUtf8(err.ErrorMessage());
+				callback(userData, false, message.data(), message.size());
+			}
+			return S_OK;
+		}).Get());
+}
+
+bool WebWindow::CaptureSnapshot(int x, int y, int width, int height, int targetWidth, int targetHeight,
+	unsigned char* buffer, int stride, SnapshotCapturedCallback callback, void* userData)
+{
+	// Not implemented on Windows yet. WebView2 can only capture to an encoded image stream.
+	return false;
+}
+
 void WebWindow::AddCustomScheme(AutoString scheme, WebResourceRequestedCallback requestHandler)
 {
 	_schemeToRequestHandler[scheme] = requestHandler;
@@ -398,6 +513,46 @@ void WebWindow::SetTopmost(bool topmost)
 	SetWindowPos(_hWnd, topmost ? HWND_TOPMOST : HWND_NOTOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
 }
 
+bool WebWindow::EnableBackgroundMessageDelivery()
+{
+	// Not implemented on Windows yet. Messages are delivered on the UI thread.
+	return false;
+}
+
+bool WebWindow::EnableHeadlessMode(int width, int height)
+{
+	// Not implemented on Windows yet
+	return false;
+}
+
+bool WebWindow::GetMemoryUsage(MemoryUsage* usage)
+{
+	// Not implemented on Windows yet
+	return false;
+}
+
+void WebWindow::GetWebProcesses(GetWebProcessesCallback callback)
+{
+	// Not implemented on Windows yet
+}
+
+void WebWindow::TrimMemory(int level)
+{
+	// Not implemented on Windows yet
+}
+
+bool WebWindow::SetWebProcessMemoryLimit(int megabytes)
+{
+	// Not implemented on Windows yet
+	return false;
+}
+
+bool WebWindow::EnableMemoryPressureMonitoring(MemoryPressureCallback callback)
+{
+	// Not implemented on Windows yet
+	return false;
+}
+
 void WebWindow::SetIconFile(AutoString filename)
 {
 	HICON icon = (HICON)LoadImage(NULL, filename, IMAGE_ICON, 0, 0, LR_LOADFROMFILE);
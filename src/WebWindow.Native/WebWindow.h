@@ -1,6 +1,10 @@
 #ifndef WEBWINDOW_H
 #define WEBWINDOW_H
 
+#include <string_view>
+#include <cstdint>
+#include <atomic>
+
 #ifdef _WIN32
 #include <Windows.h>
 #include <wrl/event.h>
@@ -12,10 +16,26 @@ typedef const wchar_t* AutoString;
 #else
 #ifdef OS_LINUX
 #include <gtk/gtk.h>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 #endif
 typedef char* AutoString;
 #endif
 
+struct MemoryUsage
+{
+	int64_t processResidentBytes;
+	int64_t webProcessResidentBytes; // All of the browser engine's helper processes
+	int webProcessCount;
+	int64_t diskCacheBytes;
+};
+
 struct Monitor
 {
 	struct MonitorRect
@@ -31,6 +51,18 @@ typedef void* (*WebResourceRequestedCallback)(AutoString url, int* outNumBytes,
 typedef int (*GetAllMonitorsCallback)(const Monitor* monitor);
 typedef void (*ResizedCallback)(int width, int height);
 typedef void (*MovedCallback)(int x, int y);
+typedef void (*EvaluateScriptCallback)(void* userData, int succeeded, const char* utf8ResultJsonOrError, size_t length);
+typedef void (*SnapshotCapturedCallback)(void* userData, int succeeded);
+typedef int (*GetWebProcessesCallback)(int pid, const char* name, int64_t residentBytes);
+typedef void (*MemoryPressureCallback)(int level);
+
+// Must match MemoryTrimLevel in WebWindow.cs
+enum MemoryTrimLevel
+{
+	MemoryTrimLevelLight = 1,
+	MemoryTrimLevelModerate = 2,
+	MemoryTrimLevelCritical = 3,
+};
 
 class WebWindow
 {
@@ -38,6 +70,7 @@ private:
 	WebMessageReceivedCallback _webMessageReceivedCallback;
 	MovedCallback _movedCallback;
 	ResizedCallback _resizedCallback;
+	MemoryPressureCallback _memoryPressureCallback;
 #ifdef _WIN32
 	static HINSTANCE _hInstance;
 	HWND _hWnd;
@@ -49,10 +82,44 @@ private:
 #elif OS_LINUX
 	GtkWidget* _window;
 	GtkWidget* _webview;
+	bool _isRootWindow;
+	bool _isHeadless;
+	int _headlessWidth;
+	int _headlessHeight;
+	void ConnectWindowSignals();
+	bool _deliverMessagesOnBackgroundThread;
+	bool _isMessageDeliveryStopping;
+	std::atomic<bool> _isMessageDeliveryFinished;
+	std::thread _messageDeliveryThread;
+	std::mutex _messageQueueMutex;
+	std::condition_variable _messageQueueNotifier;
+	struct QueuedWebMessage
+	{
+		char* message;
+		int64_t receivedMicros;
+	};
+	std::deque<QueuedWebMessage> _messageQueue;
+	void RunMessageDelivery();
+	int _eventLoopFd;
+	std::vector<GPollFD> _pollFds;
+	std::map<int, unsigned int> _eventLoopFdEvents;
+	bool IterateEventLoop(int* nextTimeoutMillis);
+	void UpdateEventLoopFd(int numPollFds);
+	int _memoryPressureFd;
+	int _memoryPressureStopFd;
+	std::thread _memoryPressureThread;
+	std::atomic<GSource*> _pendingMemoryPressure;
+	void RunMemoryPressureMonitor();
+	struct EvaluateScriptInfo;
+	GCancellable* _evaluationsCancellable;
+	std::set<EvaluateScriptInfo*> _pendingEvaluations;
+	std::string _diskCacheDirectory;
 #elif OS_MAC
 	void* _window;
 	void* _webview;
 	void* _webviewConfiguration;
+	void* _windowCloseObserver;
+	bool _isClosed;
 	void AttachWebView();
 #endif
 
@@ -67,14 +134,24 @@ public:
 
 	WebWindow(AutoString title, WebWindow* parent, WebMessageReceivedCallback webMessageReceivedCallback);
 	~WebWindow();
+	static void DestroyOnUiThread(WebWindow* instance);
+	void StopBackgroundThreads();
 	void SetTitle(AutoString title);
+	void SetTitleUtf8(std::string_view title);
 	void Show();
 	void WaitForExit();
+	bool Pump(int maxMillis, int* nextTimeoutMillis);
+	int GetEventLoopFd();
 	void ShowMessage(AutoString title, AutoString body, unsigned int type);
 	void Invoke(ACTION callback);
 	void NavigateToUrl(AutoString url);
 	void NavigateToString(AutoString content);
+	void NavigateToStringUtf8(std::string_view content);
 	void SendMessage(AutoString message);
+	void SendMessageUtf8(std::string_view message);
+	void EvaluateScript(std::string_view script, EvaluateScriptCallback callback, void* userData);
+	bool CaptureSnapshot(int x, int y, int width, int height, int targetWidth, int targetHeight,
+		unsigned char* buffer, int stride, SnapshotCapturedCallback callback, void* userData);
 	void AddCustomScheme(AutoString scheme, WebResourceRequestedCallback requestHandler);
 	void SetResizable(bool resizable);
 	void GetSize(int* width, int* height);
@@ -89,6 +166,17 @@ public:
 	void InvokeMoved(int x, int y) { if (_movedCallback) _movedCallback(x, y); }
 	void SetTopmost(bool topmost);
 	void SetIconFile(AutoString filename);
+	bool EnableBackgroundMessageDelivery();
+	bool EnableHeadlessMode(int width, int height);
+	bool GetMemoryUsage(MemoryUsage* usage);
+	void GetWebProcesses(GetWebProcessesCallback callback);
+	void TrimMemory(int level);
+	bool SetWebProcessMemoryLimit(int megabytes);
+	bool EnableMemoryPressureMonitoring(MemoryPressureCallback callback);
+	void InvokeMemoryPressure(int level) { if (_memoryPressureCallback) _memoryPressureCallback(level); }
+#ifdef OS_LINUX
+	void ReceiveWebMessage(char* message);
+#endif
 };
 
 #endif // !WEBWINDOW_H
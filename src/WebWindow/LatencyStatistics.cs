@@ -0,0 +1,117 @@
+﻿using System;
+using System.Runtime.InteropServices;
+
+namespace WebWindows
+{
+    /// <summary>
+    /// The stages of an interaction, from a DOM event in the browser to the resulting DOM update.
+    /// </summary>
+    public enum LatencyStage
+    {
+        // Must match LatencyStage in WebWindow.Latency.h
+
+        /// <summary>From the DOM event firing to the browser sending the message that reports it.</summary>
+        BrowserEventToSend = 0,
+
+        /// <summary>From the native layer receiving a web message to handing it to .NET. Measured for every message.</summary>
+        NativeMessageDelivery = 1,
+
+        /// <summary>From .NET receiving the message to the event being dispatched on the synchronization context.</summary>
+        DispatchQueue = 2,
+
+        /// <summary>From the event being dispatched to the resulting render batch being ready.</summary>
+        Handler = 3,
+
+        /// <summary>Serializing the render batch and queuing it to be sent to the browser.</summary>
+        RenderAndSend = 4,
+
+        /// <summary>From the browser receiving the render batch to the DOM being updated.</summary>
+        BrowserApply = 5,
+
+        /// <summary>Whatever the end-to-end time doesn't attribute to another stage, which is mostly the two IPC hops.</summary>
+        Transit = 6,
+
+        /// <summary>From the DOM event firing to the DOM being updated.</summary>
+        EndToEnd = 7,
+    }
+
+    public readonly struct LatencyPercentiles
+    {
+        public readonly long Count;
+        public readonly TimeSpan P50;
+        public readonly TimeSpan P95;
+        public readonly TimeSpan P99;
+        public readonly TimeSpan Max;
+
+        public LatencyPercentiles(long count, TimeSpan p50, TimeSpan p95, TimeSpan p99, TimeSpan max)
+        {
+            Count = count;
+            P50 = p50;
+            P95 = p95;
+            P99 = p99;
+            Max = max;
+        }
+    }
+
+    /// <summary>
+    /// Process-wide latency histograms, kept in native code so that every layer can record into them.
+    /// </summary>
+    public static class LatencyStatistics
+    {
+        const string DllName = "WebWindow.Native";
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_EnableLatencyTracking(int enabled);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_RecordLatency(int stage, long micros);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern int WebWindow_GetLatencyPercentiles(int stage, out NativeLatencyPercentiles percentiles);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_DumpLatencyStatistics();
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_ResetLatencyStatistics();
+
+        private static volatile bool _isEnabled;
+
+        /// <summary>
+        /// Whether interactions are being measured. Off by default, since it adds a little work to every event.
+        /// </summary>
+        public static bool IsEnabled
+        {
+            get => _isEnabled;
+            set
+            {
+                WebWindow_EnableLatencyTracking(value ? 1 : 0);
+                _isEnabled = value;
+            }
+        }
+
+        public static void Record(LatencyStage stage, TimeSpan duration)
+            => WebWindow_RecordLatency((int)stage, duration.Ticks / (TimeSpan.TicksPerMillisecond / 1000));
+
+        public static LatencyPercentiles GetPercentiles(LatencyStage stage)
+        {
+            WebWindow_GetLatencyPercentiles((int)stage, out var percentiles);
+            return new LatencyPercentiles(
+                percentiles.count,
+                MicrosToTimeSpan(percentiles.p50Micros),
+                MicrosToTimeSpan(percentiles.p95Micros),
+                MicrosToTimeSpan(percentiles.p99Micros),
+                MicrosToTimeSpan(percentiles.maxMicros));
+        }
+
+        /// <summary>
+        /// Writes a table of every stage's percentiles to standard error.
+        /// </summary>
+        public static void Dump() => WebWindow_DumpLatencyStatistics();
+
+        public static void Reset() => WebWindow_ResetLatencyStatistics();
+
+        private static TimeSpan MicrosToTimeSpan(long micros)
+            => TimeSpan.FromTicks(micros * (TimeSpan.TicksPerMillisecond / 1000));
+
+        [StructLayout(LayoutKind.Sequential)]
+        struct NativeLatencyPercentiles
+        {
+            public long count;
+            public long p50Micros;
+            public long p95Micros;
+            public long p99Micros;
+            public long maxMicros;
+        }
+    }
+}
@@ -1,9 +1,14 @@
 ﻿using System;
+using System.Buffers;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.Drawing;
 using System.IO;
+using System.Text;
+using System.Runtime;
 using System.Runtime.InteropServices;
 using System.Threading;
+using System.Threading.Tasks;
 
 namespace WebWindows
 {
@@ -14,6 +19,15 @@ namespace WebWindows
         public int width, height;
     }
 
+    [StructLayout(LayoutKind.Sequential)]
+    struct NativeMemoryUsage
+    {
+        public long processResidentBytes;
+        public long webProcessResidentBytes;
+        public int webProcessCount;
+        public long diskCacheBytes;
+    }
+
     [StructLayout(LayoutKind.Sequential)]
     struct NativeMonitor
     {
@@ -41,7 +55,7 @@ namespace WebWindows
         { }
     }
 
-    public class WebWindow
+    public class WebWindow : IDisposable
     {
         // Here we use auto charset instead of forcing UTF-8.
         // Thus the native code for Windows will be much more simple.
@@ -55,21 +69,33 @@ namespace WebWindows
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)] delegate int GetAllMonitorsCallback(in NativeMonitor monitor);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)] delegate void ResizedCallback(int width, int height);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)] delegate void MovedCallback(int x, int y);
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)] delegate void EvaluateScriptCallback(IntPtr userData, int succeeded, IntPtr utf8ResultJsonOrError, UIntPtr length);
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)] delegate void SnapshotCapturedCallback(IntPtr userData, int succeeded);
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)] delegate int GetWebProcessesCallback(int pid, [MarshalAs(UnmanagedType.LPUTF8Str)] string name, long residentBytes);
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)] delegate void MemoryPressureCallback(int level);
 
         const string DllName = "WebWindow.Native";
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern IntPtr WebWindow_register_win32(IntPtr hInstance);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern IntPtr WebWindow_register_mac();
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Auto)] static extern IntPtr WebWindow_ctor(string title, IntPtr parentWebWindow, OnWebMessageReceivedCallback webMessageReceivedCallback);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_dtor(IntPtr instance);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_DestroyOnUiThread(IntPtr instance);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern IntPtr WebWindow_getHwnd_win32(IntPtr instance);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Auto)] static extern void WebWindow_SetTitle(IntPtr instance, string title);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_SetTitleUtf8(IntPtr instance, ref byte utf8, UIntPtr length);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_Show(IntPtr instance);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_WaitForExit(IntPtr instance);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern int WebWindow_Pump(IntPtr instance, int maxMillis, out int nextTimeoutMillis);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern int WebWindow_GetEventLoopFd(IntPtr instance);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_Invoke(IntPtr instance, InvokeCallback callback);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Auto)] static extern void WebWindow_NavigateToString(IntPtr instance, string content);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_NavigateToStringUtf8(IntPtr instance, ref byte utf8, UIntPtr length);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Auto)] static extern void WebWindow_NavigateToUrl(IntPtr instance, string url);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Auto)] static extern void WebWindow_ShowMessage(IntPtr instance, string title, string body, uint type);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Auto)] static extern void WebWindow_SendMessage(IntPtr instance, string message);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_SendMessageUtf8(IntPtr instance, ref byte utf8, UIntPtr length);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_EvaluateScript(IntPtr instance, ref byte utf8Script, UIntPtr length, EvaluateScriptCallback callback, IntPtr userData);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern unsafe int WebWindow_CaptureSnapshot(IntPtr instance, int x, int y, int width, int height, int targetWidth, int targetHeight, void* buffer, int stride, SnapshotCapturedCallback callback, IntPtr userData);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Auto)] static extern void WebWindow_AddCustomScheme(IntPtr instance, string scheme, OnWebResourceRequestedCallback requestHandler);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_SetResizable(IntPtr instance, int resizable);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_GetSize(IntPtr instance, out int width, out int height);
@@ -82,9 +108,20 @@ namespace WebWindows
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_SetMovedCallback(IntPtr instance, MovedCallback callback);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_SetTopmost(IntPtr instance, int topmost);
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Auto)] static extern void WebWindow_SetIconFile(IntPtr instance, string filename);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern int WebWindow_EnableBackgroundMessageDelivery(IntPtr instance);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern int WebWindow_EnableHeadlessMode(IntPtr instance, int width, int height);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern int WebWindow_GetMemoryUsage(IntPtr instance, out NativeMemoryUsage usage);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_GetWebProcesses(IntPtr instance, GetWebProcessesCallback callback);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern void WebWindow_TrimMemory(IntPtr instance, int level);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern int WebWindow_SetWebProcessMemoryLimit(IntPtr instance, int megabytes);
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)] static extern int WebWindow_EnableMemoryPressureMonitoring(IntPtr instance, MemoryPressureCallback callback);
+
+        // One delegate serves every evaluation. Each call's TaskCompletionSource travels through
+        // native code as a GCHandle in the userData parameter.
+        private static readonly EvaluateScriptCallback _evaluateScriptCallback = OnScriptEvaluated;
+        private static readonly SnapshotCapturedCallback _snapshotCapturedCallback = OnSnapshotCaptured;
 
         private readonly List<GCHandle> _gcHandlesToFree = new List<GCHandle>();
-        private readonly List<IntPtr> _hGlobalToFree = new List<IntPtr>();
         private readonly IntPtr _nativeWebWindow;
         private readonly int _ownerThreadId;
         private string _title;
@@ -132,6 +169,28 @@ namespace WebWindows
             var parentPtr = options.Parent?._nativeWebWindow ?? default;
             _nativeWebWindow = WebWindow_ctor(_title, parentPtr, onWebMessageReceivedDelegate);
 
+            if (options.Headless)
+            {
+                IsHeadless = WebWindow_EnableHeadlessMode(_nativeWebWindow, options.HeadlessViewportWidth, options.HeadlessViewportHeight) != 0;
+            }
+
+            if (options.WebProcessMemoryLimitMegabytes > 0)
+            {
+                WebWindow_SetWebProcessMemoryLimit(_nativeWebWindow, options.WebProcessMemoryLimitMegabytes);
+            }
+
+            if (options.TrimMemoryOnPressure)
+            {
+                var onMemoryPressureDelegate = (MemoryPressureCallback)OnMemoryPressure;
+                _gcHandlesToFree.Add(GCHandle.Alloc(onMemoryPressureDelegate));
+                IsMonitoringMemoryPressure = WebWindow_EnableMemoryPressureMonitoring(_nativeWebWindow, onMemoryPressureDelegate) != 0;
+            }
+
+            if (options.DeliverWebMessagesOnBackgroundThread)
+            {
+                WebMessagesDeliveredOnBackgroundThread = WebWindow_EnableBackgroundMessageDelivery(_nativeWebWindow) != 0;
+            }
+
             foreach (var (schemeName, handler) in options.SchemeHandlers)
             {
                 AddCustomScheme(schemeName, handler);
@@ -150,27 +209,72 @@ namespace WebWindows
             Show();
         }
 
-        ~WebWindow()
+        private volatile bool _isDisposed;
+        private readonly CancellationTokenSource _disposedCancellation = new CancellationTokenSource();
+
+        /// <summary>
+        /// Stops the window's background threads and destroys it. This runs on the UI thread, so
+        /// unless it's called on the thread that created the window, the message loop must still be running.
+        /// </summary>
+        public void Dispose()
         {
-            // TODO: IDisposable
+            if (_isDisposed)
+            {
+                return;
+            }
+
+            _isDisposed = true;
+            _disposedCancellation.Cancel();
             WebWindow_SetResizedCallback(_nativeWebWindow, null);
             WebWindow_SetMovedCallback(_nativeWebWindow, null);
+
+            // While the native side waits for the message delivery thread to stop, it keeps the UI
+            // loop running, so a handler on that thread that's waiting on Invoke can still finish
+            Invoke(() => WebWindow_dtor(_nativeWebWindow));
+
             foreach (var gcHandle in _gcHandlesToFree)
             {
                 gcHandle.Free();
             }
             _gcHandlesToFree.Clear();
-            foreach (var handle in _hGlobalToFree)
-            {
-                Marshal.FreeHGlobal(handle);
-            }
-            _hGlobalToFree.Clear();
-            WebWindow_dtor(_nativeWebWindow);
+            GC.SuppressFinalize(this);
+        }
+
+        ~WebWindow()
+        {
+            WebWindow_SetResizedCallback(_nativeWebWindow, null);
+            WebWindow_SetMovedCallback(_nativeWebWindow, null);
+
+            // We're on the finalizer thread, so the native window is destroyed later on the UI thread.
+            // Until then it can still call the other delegates, so their handles are deliberately not freed.
+            WebWindow_DestroyOnUiThread(_nativeWebWindow);
         }
 
         public void Show() => WebWindow_Show(_nativeWebWindow);
         public void WaitForExit() => WebWindow_WaitForExit(_nativeWebWindow);
 
+        /// <summary>
+        /// Processes pending UI work on the calling thread for at most <paramref name="maxMillis"/>
+        /// milliseconds, without blocking if there is none. This is an alternative to <see cref="WaitForExit"/>
+        /// for hosts that run their own event loop, and must be called on the thread that created the window.
+        /// </summary>
+        /// <param name="maxMillis">The maximum time to spend dispatching work.</param>
+        /// <param name="nextTimeoutMillis">
+        /// The longest the host may wait before calling <see cref="Pump"/> again, or -1 to wait
+        /// only for <see cref="EventLoopFileDescriptor"/> to become readable. This is never -1 on
+        /// platforms without an event loop file descriptor, so hosts there end up polling.
+        /// </param>
+        /// <returns>False once the window has been closed.</returns>
+        public bool Pump(int maxMillis, out int nextTimeoutMillis)
+            => WebWindow_Pump(_nativeWebWindow, maxMillis, out nextTimeoutMillis) != 0;
+
+        /// <summary>
+        /// Gets a file descriptor that becomes readable whenever <see cref="Pump"/> has work to do,
+        /// suitable for adding to an epoll set or similar. It reflects the state as of the last call
+        /// to <see cref="Pump"/>. Returns -1 on platforms where this is not supported.
+        /// </summary>
+        public int EventLoopFileDescriptor => WebWindow_GetEventLoopFd(_nativeWebWindow);
+
         public string Title
         {
             get => _title;
@@ -219,6 +323,16 @@ namespace WebWindows
             WebWindow_NavigateToString(_nativeWebWindow, content);
         }
 
+        // The *Utf8 methods take UTF-8 text that doesn't need to be null-terminated. The span is
+        // pinned for the duration of the call and passed straight through, with no marshalling copy.
+        // Note that Windows still has to convert it to UTF-16 internally, so there the string
+        // overloads are cheaper.
+
+        public void NavigateToStringUtf8(ReadOnlySpan<byte> utf8Content)
+        {
+            WebWindow_NavigateToStringUtf8(_nativeWebWindow, ref MemoryMarshal.GetReference(utf8Content), (UIntPtr)utf8Content.Length);
+        }
+
         public void NavigateToUrl(string url)
         {
             WebWindow_NavigateToUrl(_nativeWebWindow, url);
@@ -236,8 +350,357 @@ namespace WebWindows
             WebWindow_SendMessage(_nativeWebWindow, message);
         }
 
+        public void SendMessageUtf8(ReadOnlySpan<byte> utf8Message)
+        {
+            WebWindow_SendMessageUtf8(_nativeWebWindow, ref MemoryMarshal.GetReference(utf8Message), (UIntPtr)utf8Message.Length);
+        }
+
+        public void SetTitleUtf8(ReadOnlySpan<byte> utf8Title)
+        {
+            var title = Encoding.UTF8.GetString(utf8Title);
+            WriteTitleField(title);
+            if (ReferenceEquals(_title, title))
+            {
+                WebWindow_SetTitleUtf8(_nativeWebWindow, ref MemoryMarshal.GetReference(utf8Title), (UIntPtr)utf8Title.Length);
+            }
+            else
+            {
+                // It was empty or had to be shortened, so the bytes we were given aren't what should be shown
+                WebWindow_SetTitle(_nativeWebWindow, _title);
+            }
+        }
+
+        /// <summary>
+        /// Runs JavaScript in the page and returns its completion value serialized as JSON.
+        /// This doesn't wait for earlier evaluations to complete, so many can be in flight at once.
+        /// </summary>
+        /// <param name="script">The script to run.</param>
+        /// <returns>A task that completes with the JSON result, or faults if the script throws.</returns>
+        public Task<string> EvaluateScriptAsync(string script)
+        {
+            var utf8Script = Encoding.UTF8.GetBytes(script);
+            var completion = new TaskCompletionSource<string>(TaskCreationOptions.RunContinuationsAsynchronously);
+            var completionHandle = GCHandle.Alloc(completion);
+            try
+            {
+                // This only blocks until the evaluation has started, not until it completes
+                Invoke(() => WebWindow_EvaluateScript(
+                    _nativeWebWindow,
+                    ref MemoryMarshal.GetReference(new ReadOnlySpan<byte>(utf8Script)),
+                    (UIntPtr)utf8Script.Length,
+                    _evaluateScriptCallback,
+                    GCHandle.ToIntPtr(completionHandle)));
+            }
+            catch
+            {
+                completionHandle.Free();
+                throw;
+            }
+
+            return completion.Task;
+        }
+
+        private static void OnScriptEvaluated(IntPtr userData, int succeeded, IntPtr utf8ResultJsonOrError, UIntPtr length)
+        {
+            var completionHandle = GCHandle.FromIntPtr(userData);
+            var completion = (TaskCompletionSource<string>)completionHandle.Target;
+            completionHandle.Free();
+
+            var resultJsonOrError = Marshal.PtrToStringUTF8(utf8ResultJsonOrError, (int)length);
+            if (succeeded != 0)
+            {
+                completion.SetResult(resultJsonOrError);
+            }
+            else
+            {
+                completion.SetException(new InvalidOperationException($"Script evaluation failed: {resultJsonOrError}"));
+            }
+        }
+
+        /// <summary>
+        /// Captures a region of the visible page, scaled to <paramref name="outputSize"/>, into a
+        /// caller-supplied buffer as premultiplied BGRA pixels. The buffer is pinned until the task completes.
+        /// </summary>
+        /// <param name="region">The region to capture, in CSS pixels relative to the top left of the viewport.</param>
+        /// <param name="outputSize">The size in pixels to scale the region to.</param>
+        /// <param name="buffer">Receives the pixels. Must hold <paramref name="outputSize"/>.Height rows of <paramref name="stride"/> bytes.</param>
+        /// <param name="stride">The number of bytes from the start of one row to the next. Must be a multiple of 4.</param>
+        public unsafe Task CaptureSnapshotAsync(Rectangle region, Size outputSize, Memory<byte> buffer, int stride)
+        {
+            if (region.Width <= 0 || region.Height <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(region));
+            }
+
+            if (outputSize.Width <= 0 || outputSize.Height <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(outputSize));
+            }
+
+            if (stride < outputSize.Width * 4 || stride % 4 != 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(stride));
+            }
+
+            if (buffer.Length < (long)stride * outputSize.Height)
+            {
+                throw new ArgumentException("The buffer is too small for the output size and stride.", nameof(buffer));
+            }
+
+            if (_isDisposed)
+            {
+                throw new ObjectDisposedException(nameof(WebWindow));
+            }
+
+            var capture = new SnapshotCapture { Pin = buffer.Pin() };
+            var captureHandle = GCHandle.Alloc(capture);
+            var started = false;
+            var disposed = false;
+            try
+            {
+                Invoke(() =>
+                {
+                    // Dispose destroys the native window on this thread, so this check can't race with it
+                    if (_isDisposed)
+                    {
+                        disposed = true;
+                        return;
+                    }
+
+                    started = WebWindow_CaptureSnapshot(
+                        _nativeWebWindow,
+                        region.X, region.Y, region.Width, region.Height,
+                        outputSize.Width, outputSize.Height,
+                        capture.Pin.Pointer, stride,
+                        _snapshotCapturedCallback,
+                        GCHandle.ToIntPtr(captureHandle)) != 0;
+                });
+            }
+            finally
+            {
+                if (!started)
+                {
+                    captureHandle.Free();
+                    capture.Pin.Dispose();
+                }
+            }
+
+            if (disposed)
+            {
+                throw new ObjectDisposedException(nameof(WebWindow));
+            }
+
+            if (!started)
+            {
+                throw new NotSupportedException("Snapshots are not supported on this platform.");
+            }
+
+            return capture.Completion.Task;
+        }
+
+        /// <summary>
+        /// Captures a region of the visible page, scaled to <paramref name="outputSize"/>, into a pooled buffer.
+        /// </summary>
+        /// <param name="region">The region to capture, in CSS pixels relative to the top left of the viewport.</param>
+        /// <param name="outputSize">The size in pixels to scale the region to.</param>
+        /// <returns>The snapshot, which the caller must dispose to return its buffer to the pool.</returns>
+        public Task<WebWindowSnapshot> CaptureSnapshotAsync(Rectangle region, Size outputSize)
+        {
+            // Start synchronously, so that invalid arguments and lack of platform support are thrown
+            // directly rather than through the task
+            var stride = outputSize.Width * 4;
+            var buffer = ArrayPool<byte>.Shared.Rent(Math.Max(0, stride * outputSize.Height));
+            Task capture;
+            try
+            {
+                capture = CaptureSnapshotAsync(region, outputSize, buffer, stride);
+            }
+            catch
+            {
+                ArrayPool<byte>.Shared.Return(buffer);
+                throw;
+            }
+
+            return CompleteSnapshotCapture(capture, buffer, outputSize, stride);
+        }
+
+        private static async Task<WebWindowSnapshot> CompleteSnapshotCapture(Task capture, byte[] buffer, Size outputSize, int stride)
+        {
+            try
+            {
+                await capture;
+            }
+            catch
+            {
+                ArrayPool<byte>.Shared.Return(buffer);
+                throw;
+            }
+
+            return new WebWindowSnapshot(buffer, outputSize.Width, outputSize.Height, stride);
+        }
+
+        /// <summary>
+        /// Repeatedly captures snapshots until the returned object or the window is disposed. A capture starts no sooner
+        /// than <paramref name="minInterval"/> after the previous one started, and never while the previous
+        /// one is still in progress, so a slow page lowers the rate rather than queuing up work.
+        /// </summary>
+        /// <param name="region">The region to capture, in CSS pixels relative to the top left of the viewport.</param>
+        /// <param name="outputSize">The size in pixels to scale the region to.</param>
+        /// <param name="minInterval">The minimum time between the start of one capture and the next.</param>
+        /// <param name="onCaptured">Receives each snapshot, and must dispose it.</param>
+        /// <param name="onError">
+        /// Receives any error that stops the captures, other than a single capture failing, including
+        /// exceptions thrown by <paramref name="onCaptured"/>. If null, such errors are written to the console.
+        /// </param>
+        /// <exception cref="NotSupportedException">Snapshots are not supported on this platform.</exception>
+        public IDisposable CaptureSnapshotsPeriodically(Rectangle region, Size outputSize, TimeSpan minInterval, Action<WebWindowSnapshot> onCaptured, Action<Exception> onError = null)
+        {
+            if (onCaptured is null)
+            {
+                throw new ArgumentNullException(nameof(onCaptured));
+            }
+
+            // Starting the first capture here means lack of platform support and invalid arguments
+            // are thrown to the caller, rather than silently ending the loop
+            var firstCapture = CaptureSnapshotAsync(region, outputSize);
+
+            var periodicCapture = new PeriodicSnapshotCapture(_disposedCancellation.Token);
+            _ = RunPeriodicSnapshotCapture(firstCapture, region, outputSize, minInterval, onCaptured, onError, periodicCapture.Token);
+            return periodicCapture;
+        }
+
+        // Nothing observes the returned task, so every exception is handled here
+        private async Task RunPeriodicSnapshotCapture(Task<WebWindowSnapshot> firstCapture, Rectangle region, Size outputSize, TimeSpan minInterval, Action<WebWindowSnapshot> onCaptured, Action<Exception> onError, CancellationToken cancellationToken)
+        {
+            try
+            {
+                await CapturePeriodically(firstCapture, region, outputSize, minInterval, onCaptured, cancellationToken);
+            }
+            catch (Exception) when (cancellationToken.IsCancellationRequested)
+            {
+                // Most likely the window was disposed mid-capture, which is how the loop is meant to end
+            }
+            catch (Exception ex)
+            {
+                try
+                {
+                    if (onError == null)
+                    {
+                        Console.WriteLine($"Periodic snapshot capture stopped: {ex}");
+                    }
+                    else
+                    {
+                        onError(ex);
+                    }
+                }
+                catch (Exception onErrorException)
+                {
+                    Console.WriteLine($"Periodic snapshot capture error handler failed: {onErrorException}");
+                }
+            }
+        }
+
+        private async Task CapturePeriodically(Task<WebWindowSnapshot> firstCapture, Rectangle region, Size outputSize, TimeSpan minInterval, Action<WebWindowSnapshot> onCaptured, CancellationToken cancellationToken)
+        {
+            var sinceCaptureStarted = Stopwatch.StartNew();
+            var capture = firstCapture;
+            while (true)
+            {
+                WebWindowSnapshot snapshot;
+                try
+                {
+                    snapshot = await capture;
+                }
+                catch (InvalidOperationException)
+                {
+                    // Captures can fail transiently, e.g., mid-navigation, so just skip this one
+                    snapshot = null;
+                }
+
+                if (cancellationToken.IsCancellationRequested)
+                {
+                    snapshot?.Dispose();
+                    break;
+                }
+
+                if (snapshot != null)
+                {
+                    onCaptured(snapshot);
+                }
+
+                var remaining = minInterval - sinceCaptureStarted.Elapsed;
+                if (remaining > TimeSpan.Zero)
+                {
+                    try
+                    {
+                        await Task.Delay(remaining, cancellationToken);
+                    }
+                    catch (OperationCanceledException)
+                    {
+                        break;
+                    }
+                }
+
+                if (cancellationToken.IsCancellationRequested)
+                {
+                    break;
+                }
+
+                sinceCaptureStarted.Restart();
+                capture = CaptureSnapshotAsync(region, outputSize);
+            }
+        }
+
+        private static void OnSnapshotCaptured(IntPtr userData, int succeeded)
+        {
+            var captureHandle = GCHandle.FromIntPtr(userData);
+            var capture = (SnapshotCapture)captureHandle.Target;
+            captureHandle.Free();
+            capture.Pin.Dispose();
+
+            if (succeeded != 0)
+            {
+                capture.Completion.SetResult(null);
+            }
+            else
+            {
+                capture.Completion.SetException(new InvalidOperationException("The snapshot could not be captured."));
+            }
+        }
+
+        private class SnapshotCapture
+        {
+            public readonly TaskCompletionSource<object> Completion = new TaskCompletionSource<object>(TaskCreationOptions.RunContinuationsAsynchronously);
+            public MemoryHandle Pin;
+        }
+
+        private class PeriodicSnapshotCapture : IDisposable
+        {
+            private readonly CancellationTokenSource _cancellationTokenSource;
+
+            public PeriodicSnapshotCapture(CancellationToken windowDisposed)
+            {
+                _cancellationTokenSource = CancellationTokenSource.CreateLinkedTokenSource(windowDisposed);
+            }
+
+            public CancellationToken Token => _cancellationTokenSource.Token;
+
+            public void Dispose() => _cancellationTokenSource.Cancel();
+        }
+
         public event EventHandler<string> OnWebMessageReceived;
 
+        /// <summary>
+        /// True if <see cref="OnWebMessageReceived"/> is raised on a dedicated background thread,
+        /// in the order the messages were sent. Otherwise it's raised on the UI thread.
+        /// </summary>
+        public bool WebMessagesDeliveredOnBackgroundThread { get; }
+
+        /// <summary>
+        /// True if the window renders offscreen because <see cref="WebWindowOptions.Headless"/> was requested.
+        /// </summary>
+        public bool IsHeadless { get; }
+
         private void WriteTitleField(string value)
         {
             if (string.IsNullOrEmpty(value))
@@ -275,6 +738,19 @@ namespace WebWindows
                     return default;
                 }
 
+                // Streams that are already in memory can be copied straight out
+                if (responseStream is MemoryStream memoryStream && memoryStream.TryGetBuffer(out var segment))
+                {
+                    using (memoryStream)
+                    {
+                        var position = (int)memoryStream.Position;
+                        numBytes = segment.Count - position;
+                        var buffer = Marshal.AllocCoTaskMem(numBytes);
+                        Marshal.Copy(segment.Array, segment.Offset + position, buffer, numBytes);
+                        return buffer;
+                    }
+                }
+
                 // Read the stream into memory and serve the bytes
                 // In the future, it would be possible to pass the stream through into C++
                 using (responseStream)
@@ -282,10 +758,10 @@ namespace WebWindows
                 {
                     responseStream.CopyTo(ms);
 
+                    // The native side frees this once the webview has consumed it
                     numBytes = (int)ms.Position;
-                    var buffer = Marshal.AllocHGlobal(numBytes);
+                    var buffer = Marshal.AllocCoTaskMem(numBytes);
                     Marshal.Copy(ms.GetBuffer(), 0, buffer, numBytes);
-                    _hGlobalToFree.Add(buffer);
                     return buffer;
                 }
             };
@@ -470,5 +946,78 @@ namespace WebWindows
         }
 
         public void SetIconFile(string filename) => WebWindow_SetIconFile(_nativeWebWindow, Path.GetFullPath(filename));
+
+        /// <summary>
+        /// Gets the memory used by the app, including the browser engine's helper processes and caches.
+        /// Values the platform can't report are -1. This walks the engine's disk cache, so prefer to
+        /// call it from a background thread. It doesn't need to run on the UI thread.
+        /// </summary>
+        public WebWindowMemoryUsage GetMemoryUsage()
+        {
+            var supported = WebWindow_GetMemoryUsage(_nativeWebWindow, out var usage) != 0;
+
+            return supported
+                ? new WebWindowMemoryUsage(usage.processResidentBytes, usage.webProcessResidentBytes, usage.webProcessCount, usage.diskCacheBytes, GC.GetTotalMemory(false))
+                : new WebWindowMemoryUsage(Environment.WorkingSet, -1, -1, -1, GC.GetTotalMemory(false));
+        }
+
+        /// <summary>
+        /// Gets the resident memory of each of the browser engine's helper processes, if the platform can report it.
+        /// </summary>
+        public IReadOnlyList<WebProcessMemoryUsage> WebProcesses
+        {
+            get
+            {
+                var processes = new List<WebProcessMemoryUsage>();
+                int callback(int pid, string name, long residentBytes)
+                {
+                    processes.Add(new WebProcessMemoryUsage(pid, name, residentBytes));
+                    return 1;
+                }
+                WebWindow_GetWebProcesses(_nativeWebWindow, callback);
+                return processes;
+            }
+        }
+
+        /// <summary>
+        /// Releases cached memory held by the browser engine and by .NET. The engine's caches are
+        /// shared, so this affects every window in the app, as does the reduced caching that a
+        /// <see cref="MemoryTrimLevel.Critical"/> trim leaves in place until the pressure is over.
+        /// </summary>
+        public void TrimMemory(MemoryTrimLevel level)
+        {
+            Invoke(() => WebWindow_TrimMemory(_nativeWebWindow, (int)level));
+
+            // Full collections also let ArrayPool.Shared drop buffers it's holding on to, such as
+            // the ones used for IPC and snapshots
+            if (level >= MemoryTrimLevel.Critical)
+            {
+                GCSettings.LargeObjectHeapCompactionMode = GCLargeObjectHeapCompactionMode.CompactOnce;
+                GC.Collect(2, GCCollectionMode.Forced, blocking: true, compacting: true);
+            }
+            else if (level >= MemoryTrimLevel.Moderate)
+            {
+                GC.Collect(2, GCCollectionMode.Forced, blocking: false);
+            }
+        }
+
+        /// <summary>
+        /// True if <see cref="TrimMemory"/> is called automatically when the system is under memory pressure.
+        /// </summary>
+        public bool IsMonitoringMemoryPressure { get; }
+
+        /// <summary>
+        /// Raised on the UI thread when the system comes under memory pressure, just before trimming memory.
+        /// </summary>
+        public event EventHandler<MemoryTrimLevel> MemoryPressure;
+
+        private void OnMemoryPressure(int level)
+        {
+            var trimLevel = (MemoryTrimLevel)level;
+            MemoryPressure?.Invoke(this, trimLevel);
+
+            // Don't hold up the UI thread with a blocking collection
+            Task.Run(() => TrimMemory(trimLevel));
+        }
     }
 }
@@ -0,0 +1,68 @@
+﻿namespace WebWindows
+{
+    public enum MemoryTrimLevel
+    {
+        // Must match MemoryTrimLevel in WebWindow.h
+
+        /// <summary>Clears the browser engine's in-memory resource cache.</summary>
+        Light = 1,
+
+        /// <summary>Also clears the disk cache and runs a full garbage collection.</summary>
+        Moderate = 2,
+
+        /// <summary>Also stops the engine caching resources until the pressure is over, and compacts the managed heap.</summary>
+        Critical = 3,
+    }
+
+    public readonly struct WebWindowMemoryUsage
+    {
+        /// <summary>
+        /// The resident memory of this process, or -1 if it couldn't be determined.
+        /// </summary>
+        public readonly long ProcessResidentBytes;
+
+        /// <summary>
+        /// The total resident memory of the browser engine's helper processes, or -1 if it couldn't be determined.
+        /// These are shared between all the windows in the app.
+        /// </summary>
+        public readonly long WebProcessResidentBytes;
+
+        /// <summary>
+        /// The number of browser engine helper processes, or -1 if it couldn't be determined.
+        /// </summary>
+        public readonly int WebProcessCount;
+
+        /// <summary>
+        /// The size of the browser engine's disk cache, or -1 if it couldn't be determined.
+        /// </summary>
+        public readonly long DiskCacheBytes;
+
+        /// <summary>
+        /// The size of the managed heap.
+        /// </summary>
+        public readonly long ManagedHeapBytes;
+
+        public WebWindowMemoryUsage(long processResidentBytes, long webProcessResidentBytes, int webProcessCount, long diskCacheBytes, long managedHeapBytes)
+        {
+            ProcessResidentBytes = processResidentBytes;
+            WebProcessResidentBytes = webProcessResidentBytes;
+            WebProcessCount = webProcessCount;
+            DiskCacheBytes = diskCacheBytes;
+            ManagedHeapBytes = managedHeapBytes;
+        }
+    }
+
+    public readonly struct WebProcessMemoryUsage
+    {
+        public readonly int ProcessId;
+        public readonly string Name;
+        public readonly long ResidentBytes;
+
+        public WebProcessMemoryUsage(int processId, string name, long residentBytes)
+        {
+            ProcessId = processId;
+            Name = name;
+            ResidentBytes = residentBytes;
+        }
+    }
+}
@@ -9,6 +9,45 @@ namespace WebWindows
 
         public IDictionary<string, ResolveWebResourceDelegate> SchemeHandlers { get; }
             = new Dictionary<string, ResolveWebResourceDelegate>();
+
+        /// <summary>
+        /// If true, and the platform supports it, <see cref="WebWindow.OnWebMessageReceived"/> is raised
+        /// on a dedicated background thread, in the order the messages were sent, instead of on the UI thread.
+        /// Check <see cref="WebWindow.WebMessagesDeliveredOnBackgroundThread"/> to see if it took effect.
+        /// </summary>
+        public bool DeliverWebMessagesOnBackgroundThread { get; set; }
+
+        /// <summary>
+        /// If true, and the platform supports it, the window renders offscreen at a fixed viewport size
+        /// and never appears on screen. Everything else behaves as normal. On Linux this still needs a
+        /// display connection, which can be provided by Xvfb. Check <see cref="WebWindow.IsHeadless"/>
+        /// to see if it took effect.
+        /// </summary>
+        public bool Headless { get; set; }
+
+        /// <summary>
+        /// The width in pixels of the viewport when <see cref="Headless"/> is true.
+        /// </summary>
+        public int HeadlessViewportWidth { get; set; } = 1280;
+
+        /// <summary>
+        /// The height in pixels of the viewport when <see cref="Headless"/> is true.
+        /// </summary>
+        public int HeadlessViewportHeight { get; set; } = 720;
+
+        /// <summary>
+        /// If true, and the platform supports it, <see cref="WebWindow.TrimMemory"/> is called automatically
+        /// whenever the system (or on Linux, the app's cgroup) comes under memory pressure. Check
+        /// <see cref="WebWindow.IsMonitoringMemoryPressure"/> to see if it took effect.
+        /// </summary>
+        public bool TrimMemoryOnPressure { get; set; }
+
+        /// <summary>
+        /// If greater than zero, and the platform supports it, web processes start releasing memory once
+        /// they use this many megabytes, and are terminated if they go well beyond it. The limit applies
+        /// to every window in the app, and only takes effect if set on the first window created.
+        /// </summary>
+        public int WebProcessMemoryLimitMegabytes { get; set; }
     }
 
     public delegate Stream ResolveWebResourceDelegate(string url, out string contentType);
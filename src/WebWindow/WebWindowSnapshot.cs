@@ -0,0 +1,42 @@
+﻿using System;
+using System.Buffers;
+
+namespace WebWindows
+{
+    /// <summary>
+    /// Pixels captured by <see cref="WebWindow.CaptureSnapshotAsync(System.Drawing.Rectangle, System.Drawing.Size)"/>,
+    /// in premultiplied BGRA order, one row every <see cref="Stride"/> bytes. Dispose it to
+    /// return the buffer to the pool.
+    /// </summary>
+    public sealed class WebWindowSnapshot : IDisposable
+    {
+        private byte[] _buffer;
+
+        internal WebWindowSnapshot(byte[] buffer, int width, int height, int stride)
+        {
+            _buffer = buffer;
+            Width = width;
+            Height = height;
+            Stride = stride;
+        }
+
+        public int Width { get; }
+
+        public int Height { get; }
+
+        public int Stride { get; }
+
+        public ReadOnlyMemory<byte> Pixels => _buffer is null
+            ? throw new ObjectDisposedException(nameof(WebWindowSnapshot))
+            : new ReadOnlyMemory<byte>(_buffer, 0, Stride * Height);
+
+        public void Dispose()
+        {
+            if (_buffer != null)
+            {
+                ArrayPool<byte>.Shared.Return(_buffer);
+                _buffer = null;
+            }
+        }
+    }
+}
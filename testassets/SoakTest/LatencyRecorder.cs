@@ -0,0 +1,157 @@
+﻿using System;
+using System.Diagnostics;
+using System.Numerics;
+
+namespace SoakTest
+{
+    /// <summary>
+    /// Collects the latencies of one kind of operation between samples, in a fixed-size
+    /// log-linear histogram laid out the same way as the native LatencyStatistics one. Recording
+    /// never allocates, so the recorder doesn't show up in the memory growth it's measuring.
+    /// </summary>
+    class LatencyRecorder
+    {
+        // Values below SubBucketCount microseconds get a bucket each. Above that, each power of two is
+        // split into SubBucketCount / 2 buckets, so percentiles are accurate to within about 3%.
+        private const int SubBucketBits = 6;
+        private const int SubBucketCount = 1 << SubBucketBits;
+        private const int HalfSubBucketCount = SubBucketCount / 2;
+        private const int MaxValueBits = 40;
+        private const int BucketCount = SubBucketCount + (MaxValueBits - SubBucketBits) * HalfSubBucketCount;
+
+        private readonly object _lock = new object();
+        private readonly long[] _buckets = new long[BucketCount];
+        private readonly long[] _sampleBuckets = new long[BucketCount]; // Only used by TakeSample
+        private long _maxMicros;
+        private long _totalCount;
+
+        public LatencyRecorder(string name)
+        {
+            Name = name;
+        }
+
+        public string Name { get; }
+
+        public long TotalCount
+        {
+            get
+            {
+                lock (_lock)
+                {
+                    return _totalCount;
+                }
+            }
+        }
+
+        public void Record(long startTimestamp)
+        {
+            var micros = (Stopwatch.GetTimestamp() - startTimestamp) * 1000000 / Stopwatch.Frequency;
+            var bucket = BucketIndex(Math.Max(0, micros));
+            lock (_lock)
+            {
+                _buckets[bucket]++;
+                _maxMicros = Math.Max(_maxMicros, micros);
+                _totalCount++;
+            }
+        }
+
+        /// <summary>
+        /// Gets the percentiles of everything recorded since the last call, and starts again.
+        /// Only call this from one thread at a time.
+        /// </summary>
+        public LatencySample TakeSample()
+        {
+            long maxMicros;
+            lock (_lock)
+            {
+                Array.Copy(_buckets, _sampleBuckets, BucketCount);
+                Array.Clear(_buckets, 0, BucketCount);
+                maxMicros = _maxMicros;
+                _maxMicros = 0;
+            }
+
+            long count = 0;
+            foreach (var bucketCount in _sampleBuckets)
+            {
+                count += bucketCount;
+            }
+
+            if (count == 0)
+            {
+                return default;
+            }
+
+            return new LatencySample(
+                count,
+                ToMilliseconds(Percentile(count, 0.50)),
+                ToMilliseconds(Percentile(count, 0.99)),
+                ToMilliseconds(maxMicros));
+        }
+
+        private long Percentile(long count, double fraction)
+        {
+            var target = Math.Max(1, (long)(fraction * count + 0.5));
+            long seen = 0;
+            for (var i = 0; i < BucketCount; i++)
+            {
+                seen += _sampleBuckets[i];
+                if (seen >= target)
+                {
+                    return BucketValue(i);
+                }
+            }
+
+            return BucketValue(BucketCount - 1);
+        }
+
+        private static int BucketIndex(long micros)
+        {
+            if (micros < SubBucketCount)
+            {
+                return (int)micros;
+            }
+
+            var highestBit = 63 - BitOperations.LeadingZeroCount((ulong)micros);
+            if (highestBit >= MaxValueBits)
+            {
+                return BucketCount - 1;
+            }
+
+            var shift = highestBit - SubBucketBits + 1;
+            var subBucket = (int)(micros >> shift) - HalfSubBucketCount;
+            return SubBucketCount + (highestBit - SubBucketBits) * HalfSubBucketCount + subBucket;
+        }
+
+        // Reports the middle of the bucket's range
+        private static long BucketValue(int index)
+        {
+            if (index < SubBucketCount)
+            {
+                return index;
+            }
+
+            var octave = (index - SubBucketCount) / HalfSubBucketCount;
+            var subBucket = (index - SubBucketCount) % HalfSubBucketCount + HalfSubBucketCount;
+            var shift = octave + 1;
+            return ((long)subBucket << shift) + (1L << shift) / 2;
+        }
+
+        private static double ToMilliseconds(long micros) => micros / 1000.0;
+    }
+
+    readonly struct LatencySample
+    {
+        public readonly long Count;
+        public readonly double P50Millis;
+        public readonly double P99Millis;
+        public readonly double MaxMillis;
+
+        public LatencySample(long count, double p50Millis, double p99Millis, double maxMillis)
+        {
+            Count = count;
+            P50Millis = p50Millis;
+            P99Millis = p99Millis;
+            MaxMillis = maxMillis;
+        }
+    }
+}
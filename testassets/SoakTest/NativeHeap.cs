@@ -0,0 +1,44 @@
+﻿using System;
+using System.Runtime.InteropServices;
+
+namespace SoakTest
+{
+    static class NativeHeap
+    {
+        [StructLayout(LayoutKind.Sequential)]
+        struct MallInfo2
+        {
+            public UIntPtr arena, ordblks, smblks, hblks, hblkhd, usmblks, fsmblks, uordblks, fordblks, keepcost;
+        }
+
+        [DllImport("libc", EntryPoint = "mallinfo2")] static extern MallInfo2 mallinfo2();
+
+        private static bool _isSupported = RuntimeInformation.IsOSPlatform(OSPlatform.Linux);
+
+        /// <summary>
+        /// Gets the number of bytes allocated from the C heap, or -1 on platforms where we can't tell.
+        /// </summary>
+        public static long GetAllocatedBytes()
+        {
+            if (_isSupported)
+            {
+                try
+                {
+                    var info = mallinfo2();
+                    return (long)info.uordblks.ToUInt64() + (long)info.hblkhd.ToUInt64();
+                }
+                catch (EntryPointNotFoundException)
+                {
+                    // Needs glibc 2.33 or later. The older mallinfo wraps at 2GB, which would look like drift.
+                    _isSupported = false;
+                }
+                catch (DllNotFoundException)
+                {
+                    _isSupported = false;
+                }
+            }
+
+            return -1;
+        }
+    }
+}
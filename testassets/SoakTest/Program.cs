@@ -0,0 +1,58 @@
+﻿using System;
+using System.IO;
+using System.Text;
+using WebWindows;
+
+namespace SoakTest
+{
+    /// <summary>
+    /// Drives a headless window with a steady stream of messages in both directions, Invoke calls
+    /// and custom scheme requests for a long time, sampling memory and latency as it goes. Exits
+    /// with a non-zero code if either grows by more than the configured limits.
+    ///
+    /// For example: dotnet run -c Release -- --duration-minutes 240 --max-rss-growth-mb 32
+    /// </summary>
+    class Program
+    {
+        static int Main(string[] args)
+        {
+            SoakSettings settings;
+            try
+            {
+                settings = SoakSettings.Parse(args);
+            }
+            catch (ArgumentException ex)
+            {
+                Console.Error.WriteLine(ex.Message);
+                return 2;
+            }
+
+            var schemeResponse = Encoding.UTF8.GetBytes("/*" + new string('x', settings.SchemeResponseBytes) + "*/");
+            var window = new WebWindow("Soak test", options =>
+            {
+                options.Headless = true;
+                options.DeliverWebMessagesOnBackgroundThread = true;
+                options.SchemeHandlers.Add("app", (string url, out string contentType) =>
+                {
+                    contentType = "text/javascript";
+                    return new MemoryStream(schemeResponse, 0, schemeResponse.Length, writable: false, publiclyVisible: true);
+                });
+            });
+
+            if (!window.IsHeadless)
+            {
+                Console.Error.WriteLine("Headless mode isn't supported on this platform, so the window will be visible.");
+            }
+
+            // Exits the process when it's done
+            var run = new SoakRun(window, settings);
+            window.OnWebMessageReceived += (sender, message) => run.OnWebMessageReceived(message);
+
+            window.NavigateToLocalFile("wwwroot/index.html");
+            window.WaitForExit();
+
+            Console.Error.WriteLine("The window closed before the soak test finished.");
+            return 1;
+        }
+    }
+}
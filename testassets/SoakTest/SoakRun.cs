@@ -0,0 +1,257 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.Linq;
+using System.Threading;
+using WebWindows;
+
+namespace SoakTest
+{
+    class SoakRun
+    {
+        // Latency changes smaller than this are treated as noise, however large they are relative to the baseline
+        private const double MinLatencyDriftMillis = 1.0;
+
+        private readonly WebWindow _window;
+        private readonly SoakSettings _settings;
+        private readonly string _messagePayload;
+        private readonly LatencyRecorder _messages = new LatencyRecorder("message");
+        private readonly LatencyRecorder _invokes = new LatencyRecorder("invoke");
+        private readonly LatencyRecorder _schemeRequests = new LatencyRecorder("scheme");
+        private readonly SemaphoreSlim _messageSlots;
+        private readonly SemaphoreSlim _schemeRequestSlots;
+        private readonly ConcurrentDictionary<long, long> _pendingStartTimestamps = new ConcurrentDictionary<long, long>();
+        private readonly List<Sample> _samples = new List<Sample>();
+        private long _nextId;
+        private long _schemeRequestFailures;
+        private int _started;
+
+        public SoakRun(WebWindow window, SoakSettings settings)
+        {
+            _window = window;
+            _settings = settings;
+            _messagePayload = new string('x', settings.MessageBytes);
+            _messageSlots = new SemaphoreSlim(settings.MessagesInFlight);
+            _schemeRequestSlots = new SemaphoreSlim(settings.SchemeRequestsInFlight);
+        }
+
+        private LatencyRecorder[] Recorders => new[] { _messages, _invokes, _schemeRequests };
+
+        public void OnWebMessageReceived(string message)
+        {
+            if (message == "ready")
+            {
+                if (Interlocked.Exchange(ref _started, 1) == 0)
+                {
+                    StartThread(DriveMessages);
+                    StartThread(DriveInvokes);
+                    StartThread(DriveSchemeRequests);
+                    StartThread(Monitor);
+                }
+                return;
+            }
+
+            var kind = message.Substring(0, 5);
+            var id = long.Parse(message.Substring(5), CultureInfo.InvariantCulture);
+            _pendingStartTimestamps.TryRemove(id, out var startTimestamp);
+            switch (kind)
+            {
+                case "pong:":
+                    _messages.Record(startTimestamp);
+                    _messageSlots.Release();
+                    break;
+                case "done:":
+                    _schemeRequests.Record(startTimestamp);
+                    _schemeRequestSlots.Release();
+                    break;
+                case "fail:":
+                    Interlocked.Increment(ref _schemeRequestFailures);
+                    _schemeRequestSlots.Release();
+                    break;
+            }
+        }
+
+        private static void StartThread(ThreadStart body)
+        {
+            new Thread(body) { IsBackground = true }.Start();
+        }
+
+        // Each message goes to the browser and is echoed straight back
+        private void DriveMessages()
+        {
+            while (true)
+            {
+                _messageSlots.Wait();
+                var id = Interlocked.Increment(ref _nextId);
+                _pendingStartTimestamps[id] = Stopwatch.GetTimestamp();
+                _window.Invoke(() => _window.SendMessage($"ping:{id}:{_messagePayload}"));
+            }
+        }
+
+        // Measures how long the UI thread takes to pick up work while it's busy with everything else
+        private void DriveInvokes()
+        {
+            while (true)
+            {
+                var startTimestamp = Stopwatch.GetTimestamp();
+                _window.Invoke(() => { });
+                _invokes.Record(startTimestamp);
+            }
+        }
+
+        // Each request makes the browser load a script from the app:// scheme
+        private void DriveSchemeRequests()
+        {
+            while (true)
+            {
+                _schemeRequestSlots.Wait();
+                var id = Interlocked.Increment(ref _nextId);
+                _pendingStartTimestamps[id] = Stopwatch.GetTimestamp();
+                _window.Invoke(() => _window.SendMessage($"load:{id}"));
+            }
+        }
+
+        private void Monitor()
+        {
+            var stopwatch = Stopwatch.StartNew();
+            Console.WriteLine(Sample.CsvHeader(Recorders));
+
+            while (stopwatch.Elapsed < _settings.Duration)
+            {
+                Thread.Sleep(_settings.SampleInterval);
+
+                var sample = TakeSample(stopwatch.Elapsed);
+                _samples.Add(sample);
+                Console.WriteLine(sample.ToCsv());
+
+                // Startup can legitimately stall for a while, so only check once warmup is over
+                for (var i = 0; i < sample.Latencies.Length && sample.Elapsed >= _settings.Warmup; i++)
+                {
+                    if (sample.Latencies[i].Count == 0)
+                    {
+                        Finish(new[] { $"No {Recorders[i].Name} operations completed in the last {_settings.SampleInterval.TotalSeconds}s. Something is stuck." });
+                    }
+                }
+            }
+
+            Finish(Evaluate());
+        }
+
+        private Sample TakeSample(TimeSpan elapsed)
+        {
+            // Collect first so the managed heap figure only includes live objects
+            var managedHeapBytes = GC.GetTotalMemory(forceFullCollection: true);
+            var memoryUsage = _window.GetMemoryUsage();
+            var process = Process.GetCurrentProcess();
+
+            return new Sample
+            {
+                Elapsed = elapsed,
+                ProcessResidentBytes = memoryUsage.ProcessResidentBytes >= 0 ? memoryUsage.ProcessResidentBytes : process.WorkingSet64,
+                NativeHeapBytes = NativeHeap.GetAllocatedBytes(),
+                ManagedHeapBytes = managedHeapBytes,
+                WebProcessResidentBytes = memoryUsage.WebProcessResidentBytes,
+                Latencies = Recorders.Select(recorder => recorder.TakeSample()).ToArray(),
+            };
+        }
+
+        private List<string> Evaluate()
+        {
+            var failures = new List<string>();
+
+            var schemeRequestFailures = Interlocked.Read(ref _schemeRequestFailures);
+            if (schemeRequestFailures > 0)
+            {
+                failures.Add($"{schemeRequestFailures} scheme requests failed.");
+            }
+
+            var steadySamples = _samples.Where(sample => sample.Elapsed >= _settings.Warmup).ToList();
+            if (steadySamples.Count < 4)
+            {
+                failures.Add($"Only {steadySamples.Count} samples were taken after warmup. Run for longer, or sample more often.");
+                return failures;
+            }
+
+            // Compare the first and last quarters, using minimums for memory so that a GC or
+            // cache flush that happens to land near one sample doesn't count as growth
+            var quarter = steadySamples.Count / 4;
+            var baseline = steadySamples.Take(quarter).ToList();
+            var final = steadySamples.Skip(steadySamples.Count - quarter).ToList();
+
+            void CheckGrowth(string name, Func<Sample, long> getBytes, double maxGrowthMegabytes)
+            {
+                if (steadySamples.Any(sample => getBytes(sample) < 0))
+                {
+                    Console.WriteLine($"Skipping {name} check, since it isn't available on this platform.");
+                    return;
+                }
+
+                var growthMegabytes = (final.Min(getBytes) - baseline.Min(getBytes)) / (1024.0 * 1024.0);
+                Console.WriteLine($"{name} grew by {growthMegabytes:F1}MB (limit {maxGrowthMegabytes}MB)");
+                if (growthMegabytes > maxGrowthMegabytes)
+                {
+                    failures.Add($"{name} grew by {growthMegabytes:F1}MB, which is more than the limit of {maxGrowthMegabytes}MB.");
+                }
+            }
+
+            CheckGrowth("Process RSS", sample => sample.ProcessResidentBytes, _settings.MaxRssGrowthMegabytes);
+            CheckGrowth("Native heap", sample => sample.NativeHeapBytes, _settings.MaxNativeHeapGrowthMegabytes);
+            CheckGrowth("Managed heap", sample => sample.ManagedHeapBytes, _settings.MaxManagedHeapGrowthMegabytes);
+            CheckGrowth("Web process RSS", sample => sample.WebProcessResidentBytes, _settings.MaxWebProcessGrowthMegabytes);
+
+            var recorders = Recorders;
+            for (var i = 0; i < recorders.Length; i++)
+            {
+                var baselineP99 = Median(baseline.Select(sample => sample.Latencies[i].P99Millis));
+                var finalP99 = Median(final.Select(sample => sample.Latencies[i].P99Millis));
+                Console.WriteLine($"{recorders[i].Name} p99 went from {baselineP99:F3}ms to {finalP99:F3}ms over {recorders[i].TotalCount} operations");
+                if (finalP99 > baselineP99 * _settings.MaxLatencyDrift && finalP99 - baselineP99 > MinLatencyDriftMillis)
+                {
+                    failures.Add($"{recorders[i].Name} p99 latency went from {baselineP99:F3}ms to {finalP99:F3}ms, more than {_settings.MaxLatencyDrift}x.");
+                }
+            }
+
+            return failures;
+        }
+
+        private static double Median(IEnumerable<double> values)
+        {
+            var sorted = values.OrderBy(value => value).ToArray();
+            return sorted[sorted.Length / 2];
+        }
+
+        private static void Finish(IReadOnlyList<string> failures)
+        {
+            foreach (var failure in failures)
+            {
+                Console.Error.WriteLine("FAIL: " + failure);
+            }
+
+            Console.WriteLine(failures.Count == 0 ? "PASS" : "FAIL");
+            Environment.Exit(failures.Count == 0 ? 0 : 1);
+        }
+
+        private class Sample
+        {
+            public TimeSpan Elapsed;
+            public long ProcessResidentBytes;
+            public long NativeHeapBytes;
+            public long ManagedHeapBytes;
+            public long WebProcessResidentBytes;
+            public LatencySample[] Latencies;
+
+            public static string CsvHeader(IEnumerable<LatencyRecorder> recorders)
+                => "elapsed_s,rss_mb,native_heap_mb,managed_heap_mb,web_process_rss_mb,"
+                    + string.Join(",", recorders.Select(recorder => $"{recorder.Name}_count,{recorder.Name}_p50_ms,{recorder.Name}_p99_ms,{recorder.Name}_max_ms"));
+
+            public string ToCsv()
+                => string.Join(",", new[] { Elapsed.TotalSeconds.ToString("F0", CultureInfo.InvariantCulture), Megabytes(ProcessResidentBytes), Megabytes(NativeHeapBytes), Megabytes(ManagedHeapBytes), Megabytes(WebProcessResidentBytes) }
+                    .Concat(Latencies.Select(latency => string.Format(CultureInfo.InvariantCulture, "{0},{1:F3},{2:F3},{3:F3}", latency.Count, latency.P50Millis, latency.P99Millis, latency.MaxMillis))));
+
+            private static string Megabytes(long bytes)
+                => bytes < 0 ? "" : (bytes / (1024.0 * 1024.0)).ToString("F1", CultureInfo.InvariantCulture);
+        }
+    }
+}
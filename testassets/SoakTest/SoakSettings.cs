@@ -0,0 +1,67 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+
+namespace SoakTest
+{
+    class SoakSettings
+    {
+        public TimeSpan Duration { get; set; } = TimeSpan.FromMinutes(60);
+
+        /// <summary>
+        /// Samples taken during warmup are reported, but not used as the baseline, since caches are still filling up.
+        /// </summary>
+        public TimeSpan Warmup { get; set; } = TimeSpan.FromMinutes(5);
+
+        public TimeSpan SampleInterval { get; set; } = TimeSpan.FromSeconds(30);
+
+        public int MessagesInFlight { get; set; } = 32;
+        public int MessageBytes { get; set; } = 256;
+        public int SchemeRequestsInFlight { get; set; } = 4;
+        public int SchemeResponseBytes { get; set; } = 16 * 1024;
+
+        public double MaxRssGrowthMegabytes { get; set; } = 64;
+        public double MaxNativeHeapGrowthMegabytes { get; set; } = 32;
+        public double MaxManagedHeapGrowthMegabytes { get; set; } = 16;
+        public double MaxWebProcessGrowthMegabytes { get; set; } = 128;
+
+        /// <summary>
+        /// The most each operation's p99 latency may grow by, as a multiple of its baseline.
+        /// </summary>
+        public double MaxLatencyDrift { get; set; } = 2.0;
+
+        public static SoakSettings Parse(string[] args)
+        {
+            var settings = new SoakSettings();
+            var setters = new Dictionary<string, Action<double>>
+            {
+                { "--duration-minutes", value => settings.Duration = TimeSpan.FromMinutes(value) },
+                { "--warmup-minutes", value => settings.Warmup = TimeSpan.FromMinutes(value) },
+                { "--sample-seconds", value => settings.SampleInterval = TimeSpan.FromSeconds(value) },
+                { "--messages-in-flight", value => settings.MessagesInFlight = (int)value },
+                { "--message-bytes", value => settings.MessageBytes = (int)value },
+                { "--scheme-requests-in-flight", value => settings.SchemeRequestsInFlight = (int)value },
+                { "--scheme-response-bytes", value => settings.SchemeResponseBytes = (int)value },
+                { "--max-rss-growth-mb", value => settings.MaxRssGrowthMegabytes = value },
+                { "--max-native-heap-growth-mb", value => settings.MaxNativeHeapGrowthMegabytes = value },
+                { "--max-managed-heap-growth-mb", value => settings.MaxManagedHeapGrowthMegabytes = value },
+                { "--max-web-process-growth-mb", value => settings.MaxWebProcessGrowthMegabytes = value },
+                { "--max-latency-drift", value => settings.MaxLatencyDrift = value },
+            };
+
+            for (var i = 0; i < args.Length; i += 2)
+            {
+                if (!setters.TryGetValue(args[i], out var setter)
+                    || i + 1 >= args.Length
+                    || !double.TryParse(args[i + 1], NumberStyles.Float, CultureInfo.InvariantCulture, out var value))
+                {
+                    throw new ArgumentException($"Invalid argument '{args[i]}'. Valid options are: {string.Join(", ", setters.Keys)}");
+                }
+
+                setter(value);
+            }
+
+            return settings;
+        }
+    }
+}